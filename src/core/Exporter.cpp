@@ -1,7 +1,6 @@
 #include "Exporter.h"
 #include "Exception.h"
 #include "database/Database.h"
-#include "ui/notetaking/NoteTaking.h"
 #include "ui/Birthdays.h"
 #include "core/Application.h"
 #include <QtCore/private/qzipwriter_p.h>
@@ -9,8 +8,15 @@
 #include <QMessageBox>
 #include <QDir>
 #include <QDirIterator>
+#include <QSet>
+#include <QTextDocument>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
 
-void Exporter::exportAll(const QString& filePath, NoteTaking* noteTaking, Database* database, QWidget* parent) {
+constexpr auto ManifestFile = ".memo-export.json";
+
+void Exporter::exportAll(const QString& filePath, const Ids& rootIds, Format format, Database* database, QWidget* parent) {
     QFileInfo fi(filePath);
     QString dirPath = fi.absolutePath() + "/" + fi.baseName();
 
@@ -19,13 +25,173 @@ void Exporter::exportAll(const QString& filePath, NoteTaking* noteTaking, Databa
         dir.removeRecursively();
     });
 
-    int count = noteTaking->exportNote(0, dirPath + "/notes");
-    exportBirthdays(dirPath, database);
+    Tree tree = buildTree(database->notes());
+    int count = exportNotes(tree, topIndexes(tree, rootIds), dirPath + "/notes", format);
+
+    if (rootIds.isEmpty()) {
+        exportBirthdays(dirPath, database);
+    }
+
     compressDir(dirPath);
 
     QMessageBox::information(parent, Application::Name, tr("Export Finished. Count of notes: %1").arg(count));
 }
 
+void Exporter::syncToFolder(const QString& dirPath, const Ids& rootIds, Format format, Database* database, QWidget* parent) {
+    QDir dir(dirPath);
+    Tree tree = buildTree(database->noteHeaders());
+
+    QJsonObject manifest;
+    QFile manifestFile(dir.filePath(ManifestFile));
+
+    if (manifestFile.open(QIODevice::ReadOnly)) {
+        manifest = QJsonDocument::fromJson(manifestFile.readAll()).object();
+        manifestFile.close();
+    }
+
+    QJsonArray roots;
+
+    for (Id rootId : rootIds) {
+        roots.append(rootId);
+    }
+
+    // Manifests of single root exports keep their root in "rootId".
+    QJsonArray oldRoots = manifest["rootIds"].toArray();
+
+    if (!manifest.contains("rootIds") && manifest["rootId"].toInteger()) {
+        oldRoots.append(manifest["rootId"].toInteger());
+    }
+
+    // Files written with another format or roots are stale as a whole.
+    bool compatible = manifest["format"].toInt() == int(format) && oldRoots == roots;
+    QJsonObject oldEntries = manifest["notes"].toObject();
+    QJsonObject entries;
+    QVector<int> changed;
+    QSet<QString> paths;
+
+    QVector<std::pair<int, QString>> stack;
+
+    for (int index : topIndexes(tree, rootIds)) {
+        stack.append({ index, QString() });
+    }
+
+    while (!stack.isEmpty()) {
+        auto [index, parentPath] = stack.takeLast();
+        const Note& note = tree.notes.at(index);
+
+        QString notePath = parentPath + note.title;
+        QString filePath = notePath + suffix(format);
+        QString key = QString::number(note.id);
+
+        QJsonObject entry = oldEntries[key].toObject();
+
+        if (!compatible || entry["path"].toString() != filePath || entry["updatedAt"].toString() != note.updatedAt
+                || entry["markdown"].toBool() != note.markdown) {
+            entry["path"] = filePath;
+            entry["updatedAt"] = note.updatedAt;
+            entry["markdown"] = note.markdown;
+            changed.append(index);
+        }
+
+        entries[key] = entry;
+        paths.insert(filePath);
+
+        for (int child : tree.children.value(note.id)) {
+            stack.append({ child, notePath + "/" });
+        }
+    }
+
+    // Remove files of deleted, renamed and moved notes before writing new ones.
+    int removed = 0;
+
+    for (auto it = oldEntries.constBegin(); it != oldEntries.constEnd(); it++) {
+        QString oldPath = it.value().toObject()["path"].toString();
+
+        if (!oldPath.isEmpty() && !paths.contains(oldPath)) {
+            removeFile(dir, oldPath);
+            removed++;
+        }
+    }
+
+    for (int index : changed) {
+        const Note& note = tree.notes.at(index);
+        QString filePath = dir.filePath(entries[QString::number(note.id)].toObject()["path"].toString());
+        QString text = database->noteValue(note.id, "note").toString();
+
+        QDir().mkpath(QFileInfo(filePath).absolutePath());
+        writeFile(filePath, formatNote(text, note.markdown, format));
+    }
+
+    manifest["format"] = int(format);
+    manifest.remove("rootId");
+    manifest["rootIds"] = roots;
+    manifest["notes"] = entries;
+
+    if (!manifestFile.open(QIODevice::WriteOnly)) {
+        throw RuntimeError("Write file error");
+    }
+
+    manifestFile.write(QJsonDocument(manifest).toJson(QJsonDocument::Compact));
+    manifestFile.close();
+
+    QMessageBox::information(parent, Application::Name, tr("Sync Finished. Written: %1, removed: %2, unchanged: %3")
+                             .arg(changed.count()).arg(removed).arg(entries.count() - changed.count()));
+}
+
+Exporter::Tree Exporter::buildTree(const QVector<Note>& notes) {
+    Tree result;
+    result.notes = notes;
+
+    for (int i = 0; i < notes.count(); i++) {
+        result.indexes[notes.at(i).id] = i;
+    }
+
+    // Notes are ordered by depth and position, so children come out sorted.
+    for (int i = 0; i < notes.count(); i++) {
+        result.children[notes.at(i).parentId].append(i);
+    }
+
+    return result;
+}
+
+QVector<int> Exporter::topIndexes(const Tree& tree, const Ids& rootIds) {
+    if (rootIds.isEmpty()) {
+        return tree.children.value(0);
+    }
+
+    QVector<int> result;
+
+    for (Id rootId : rootIds) {
+        if (tree.indexes.contains(rootId)) {
+            result.append(tree.indexes.value(rootId));
+        }
+    }
+
+    return result;
+}
+
+int Exporter::exportNotes(const Tree& tree, const QVector<int>& indexes, const QString& path, Format format) {
+    QDir().mkpath(path);
+
+    int count = 0;
+
+    for (int index : indexes) {
+        const Note& note = tree.notes.at(index);
+        QString notePath = path + "/" + note.title;
+
+        writeFile(notePath + suffix(format), formatNote(note.note, note.markdown, format));
+        count++;
+
+        QVector<int> children = tree.children.value(note.id);
+
+        if (!children.isEmpty()) {
+            count += exportNotes(tree, children, notePath, format);
+        }
+    }
+
+    return count;
+}
+
 void Exporter::exportBirthdays(const QString& dirPath, Database* database) {
     QString filename = dirPath + "/birthdays.txt";
     QFile file(filename);
@@ -80,3 +246,49 @@ void Exporter::compressDir(const QString& dirPath) {
 
     zipWriter.close();
 }
+
+QString Exporter::formatNote(const QString& note, bool markdown, Format format) {
+    if (format == Format::Text || (format == Format::Markdown && markdown)) {
+        return note;
+    }
+
+    QTextDocument document;
+
+    if (markdown) {
+        document.setMarkdown(note);
+    } else {
+        document.setPlainText(note);
+    }
+
+    return format == Format::Html ? document.toHtml() : document.toMarkdown();
+}
+
+QString Exporter::suffix(Format format) {
+    switch (format) {
+        case Format::Text: return ".txt";
+        case Format::Markdown: return ".md";
+        case Format::Html: return ".html";
+    }
+
+    return QString();
+}
+
+void Exporter::writeFile(const QString& filePath, const QString& text) {
+    QFile file(filePath);
+
+    if (file.open(QIODevice::WriteOnly)) {
+        QTextStream stream(&file);
+        stream << text;
+    }
+}
+
+void Exporter::removeFile(const QDir& dir, const QString& relativeFilePath) {
+    QFile::remove(dir.filePath(relativeFilePath));
+
+    // Drop directories left empty by the removed note.
+    QString relativeDirPath = QFileInfo(relativeFilePath).path();
+
+    while (relativeDirPath != "." && dir.rmdir(relativeDirPath)) {
+        relativeDirPath = QFileInfo(relativeDirPath).path();
+    }
+}
@@ -1,17 +1,42 @@
 #pragma once
+#include "Model.h"
 #include <QObject>
+#include <QHash>
 
 class QString;
+class QDir;
 
-class NoteTaking;
 class Database;
 
 class Exporter : public QObject {
     Q_OBJECT
 public:
-    static void exportAll(const QString& filePath, NoteTaking* noteTaking, Database* database, QWidget* parent);
+    enum class Format {
+        Text,
+        Markdown,
+        Html
+    };
+
+    // Empty root ids mean all notes.
+    static void exportAll(const QString& filePath, const Ids& rootIds, Format format, Database* database, QWidget* parent);
+    static void syncToFolder(const QString& dirPath, const Ids& rootIds, Format format, Database* database, QWidget* parent);
 
 private:
+    struct Tree {
+        QVector<Note> notes;
+        QHash<Id, int> indexes;
+        QHash<Id, QVector<int>> children;
+    };
+
+    static Tree buildTree(const QVector<Note>& notes);
+    static QVector<int> topIndexes(const Tree& tree, const Ids& rootIds);
+
+    static int exportNotes(const Tree& tree, const QVector<int>& indexes, const QString& path, Format format);
     static void exportBirthdays(const QString& dirPath, Database* database);
     static void compressDir(const QString& dirPath);
+
+    static QString formatNote(const QString& note, bool markdown, Format format);
+    static QString suffix(Format format);
+    static void writeFile(const QString& filePath, const QString& text);
+    static void removeFile(const QDir& dir, const QString& relativeFilePath);
 };
@@ -0,0 +1,332 @@
+#include "Importer.h"
+#include "Exception.h"
+#include "database/Database.h"
+#include "ui/notetaking/NoteTaking.h"
+#include "ui/Birthdays.h"
+#include "core/Application.h"
+#include <QtCore/private/qzipreader_p.h>
+#include <QtConcurrent>
+#include <QThread>
+#include <QCollator>
+#include <QFileInfo>
+#include <QMessageBox>
+#include <QDir>
+#include <QDirIterator>
+
+constexpr auto NotesDir = "notes";
+constexpr auto BirthdaysFile = "birthdays.txt";
+constexpr auto SkippedFilesShown = 10;
+constexpr auto RangesPerThread = 4;
+
+void Importer::importAll(const QString& path, NoteTaking* noteTaking, Database* database, QWidget* parent) {
+    Source source = QFileInfo(path).isDir() ? readDir(path) : readZip(path);
+    QString prefix;
+    QString birthdaysPath;
+
+    // Archive created by Exporter: notes are in the "notes" directory next to "birthdays.txt",
+    // usually wrapped in one top-level directory. Any other layout is imported as is.
+    for (const QString& exportPrefix : { rootPrefix(source), QString() }) {
+        if (!isExported(source, exportPrefix)) continue;
+
+        if (source.files.contains(exportPrefix + BirthdaysFile)) {
+            birthdaysPath = exportPrefix + BirthdaysFile;
+        }
+
+        prefix = exportPrefix + NotesDir + "/";
+        break;
+    }
+
+    QStringList skippedFiles;
+    QVector<Node> nodes = buildTree(source, prefix, skippedFiles);
+    sortChildren(nodes);
+    loadNotes(source, nodes);
+
+    int count = 0;
+    database->transaction();
+
+    try {
+        count = insertTree(nodes, database);
+
+        if (!birthdaysPath.isEmpty()) {
+            importBirthdays(fileData(source, birthdaysPath), database);
+        }
+
+        database->commit();
+    } catch (...) {
+        database->rollback();
+        throw;
+    }
+
+    noteTaking->build();
+
+    QString message = tr("Import Finished. Count of notes: %1").arg(count);
+
+    if (!skippedFiles.isEmpty()) {
+        message += "\n\n" + tr("Skipped files that are not .txt or .md: %1").arg(skippedFiles.count());
+        message += "\n" + skippedFiles.mid(0, SkippedFilesShown).join("\n");
+
+        if (skippedFiles.count() > SkippedFilesShown) {
+            message += "\n...";
+        }
+    }
+
+    QMessageBox::information(parent, Application::Name, message);
+}
+
+Importer::Source Importer::readDir(const QString& dirPath) {
+    Source result;
+    result.path = QDir(dirPath).absolutePath();
+
+    QDir dir(result.path);
+    QDirIterator it(result.path, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+
+    while (it.hasNext()) {
+        QString relativeFilePath = dir.relativeFilePath(it.next());
+
+        if (it.fileInfo().isDir()) {
+            result.dirs.append(relativeFilePath);
+        } else if (it.fileInfo().isFile()) {
+            result.files.append(relativeFilePath);
+        }
+    }
+
+    return result;
+}
+
+Importer::Source Importer::readZip(const QString& filePath) {
+    // Only the listing is read here, entries are inflated when the notes are loaded.
+    QZipReader zipReader(filePath);
+
+    switch (zipReader.status()) {
+        case QZipReader::FileReadError: throw RuntimeError("Read file error");
+        case QZipReader::FileOpenError: throw RuntimeError("Open file error");
+        case QZipReader::FilePermissionsError: throw RuntimeError("Permissions file error");
+        case QZipReader::FileError: throw RuntimeError("File error");
+        case QZipReader::NoError: break;
+    }
+
+    Source result;
+    result.path = filePath;
+    result.isZip = true;
+
+    for (const auto& fileInfo : zipReader.fileInfoList()) {
+        QString path = QDir::cleanPath(fileInfo.filePath);
+
+        if (fileInfo.isDir) {
+            result.dirs.append(path);
+        } else if (fileInfo.isFile) {
+            result.files.append(path);
+            result.zipEntries[path] = fileInfo.filePath;
+        }
+    }
+
+    zipReader.close();
+
+    return result;
+}
+
+QByteArray Importer::fileData(const Source& source, const QString& filePath) {
+    if (source.isZip) {
+        QZipReader zipReader(source.path);
+        return zipReader.fileData(source.zipEntries.value(filePath));
+    }
+
+    QFile file(source.path + "/" + filePath);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+QString Importer::rootPrefix(const Source& source) {
+    // Single top-level directory, which every exported archive has.
+    QString top;
+
+    for (const QStringList& paths : { source.dirs, source.files }) {
+        for (const QString& path : paths) {
+            QString first = path.section('/', 0, 0);
+
+            if (top.isNull()) {
+                top = first;
+            } else if (first != top) {
+                return QString();
+            }
+        }
+    }
+
+    return !top.isEmpty() && source.dirs.contains(top) ? top + "/" : QString();
+}
+
+bool Importer::isExported(const Source& source, const QString& prefix) {
+    QString notesPrefix = prefix + NotesDir + "/";
+
+    return source.dirs.contains(prefix + NotesDir) && std::all_of(source.files.cbegin(), source.files.cend(), [&] (const QString& file) {
+        return file == prefix + BirthdaysFile || file.startsWith(notesPrefix);
+    });
+}
+
+QVector<Importer::Node> Importer::buildTree(const Source& source, const QString& prefix, QStringList& skippedFiles) {
+    QVector<Node> result(1);
+    QHash<QString, int> keys;
+    keys[QString()] = 0;
+
+    for (const QString& dir : source.dirs) {
+        if (dir.startsWith(prefix)) {
+            ensureNode(dir.mid(prefix.size()), keys, result);
+        }
+    }
+
+    for (const QString& file : source.files) {
+        if (!file.startsWith(prefix)) continue;
+
+        QString key = file.mid(prefix.size());
+        bool markdown = key.endsWith(".md");
+
+        if (markdown) {
+            key.chop(3);
+        } else if (key.endsWith(".txt")) {
+            key.chop(4);
+        } else {
+            // Images and other binary files would become notes with unreadable text.
+            skippedFiles.append(file);
+            continue;
+        }
+
+        if (key.isEmpty() || key.endsWith('/')) continue;
+
+        int index = ensureNode(key, keys, result);
+        result[index].filePath = file;
+        result[index].markdown = markdown;
+    }
+
+    return result;
+}
+
+int Importer::ensureNode(const QString& key, QHash<QString, int>& keys, QVector<Node>& nodes) {
+    auto it = keys.constFind(key);
+
+    if (it != keys.cend()) {
+        return it.value();
+    }
+
+    int slash = key.lastIndexOf('/');
+    int parent = ensureNode(slash < 0 ? QString() : key.left(slash), keys, nodes);
+
+    Node node;
+    node.title = key.mid(slash + 1);
+    nodes.append(node);
+
+    int index = nodes.size() - 1;
+    nodes[parent].children.append(index);
+    keys[key] = index;
+
+    return index;
+}
+
+void Importer::sortChildren(QVector<Node>& nodes) {
+    QCollator collator;
+    collator.setNumericMode(true);
+    collator.setCaseSensitivity(Qt::CaseInsensitive);
+
+    for (Node& node : nodes) {
+        std::sort(node.children.begin(), node.children.end(), [&] (int a, int b) {
+            return collator.compare(nodes.at(a).title, nodes.at(b).title) < 0;
+        });
+    }
+}
+
+void Importer::loadNotes(const Source& source, QVector<Node>& nodes) {
+    // Reader of an archive is not shared between threads, so every worker opens its own for a range of notes.
+    int rangeSize = qMax(1, int(nodes.size()) / (QThread::idealThreadCount() * RangesPerThread));
+    QVector<std::pair<int, int>> ranges;
+
+    for (int i = 0; i < nodes.size(); i += rangeSize) {
+        ranges.append({ i, qMin(i + rangeSize, int(nodes.size())) });
+    }
+
+    Node* data = nodes.data();
+
+    QtConcurrent::blockingMap(ranges, [&source, data] (const std::pair<int, int>& range) {
+        QScopedPointer<QZipReader> zipReader(source.isZip ? new QZipReader(source.path) : nullptr);
+
+        for (int i = range.first; i < range.second; i++) {
+            Node& node = data[i];
+
+            if (node.filePath.isEmpty()) continue;
+
+            QByteArray note = zipReader ? zipReader->fileData(source.zipEntries.value(node.filePath)) : fileData(source, node.filePath);
+            node.note = QString::fromUtf8(note);
+        }
+    });
+}
+
+int Importer::insertTree(const QVector<Node>& nodes, Database* database) {
+    // Insert level by level so that parent ids are known before their children.
+    QVector<std::pair<int, Id>> parents = { { 0, 0 } };
+    int rootPosition = database->lastPosition(0);
+    int depth = 0;
+    int result = 0;
+
+    while (!parents.isEmpty()) {
+        QVector<Note> notes;
+        QVector<int> indexes;
+
+        for (const auto& [parent, parentId] : parents) {
+            const QVector<int>& children = nodes.at(parent).children;
+            int offset = parent == 0 ? rootPosition : 0;
+
+            for (int i = 0; i < children.size(); i++) {
+                const Node& node = nodes.at(children.at(i));
+
+                Note note;
+                note.parentId = parentId;
+                note.pos = offset + (i + 1) * Database::PositionGap;
+                note.depth = depth;
+                note.title = node.title;
+                note.note = node.note;
+                note.markdown = node.markdown;
+
+                notes.append(note);
+                indexes.append(children.at(i));
+            }
+        }
+
+        Ids ids = database->insertNotes(notes);
+        parents.clear();
+
+        for (int i = 0; i < ids.size(); i++) {
+            if (!nodes.at(indexes.at(i)).children.isEmpty()) {
+                parents.append({ indexes.at(i), ids.at(i) });
+            }
+        }
+
+        result += ids.size();
+        depth++;
+    }
+
+    return result;
+}
+
+void Importer::importBirthdays(const QByteArray& data, Database* database) {
+    // Importing the same export again does not duplicate birthdays.
+    QSet<QPair<QDate, QString>> existing;
+
+    for (const Birthday& birthday : database->birthdays()) {
+        existing.insert({ birthday.date, birthday.name });
+    }
+
+    QTextStream stream(data);
+
+    while (!stream.atEnd()) {
+        QString line = stream.readLine();
+
+        Birthday birthday;
+        birthday.date = QDate::fromString(line.section(' ', 0, 0), BirthdayDateFormat);
+
+        if (!birthday.date.isValid()) continue;
+
+        birthday.name = line.section(' ', 1);
+
+        if (existing.contains({ birthday.date, birthday.name })) continue;
+
+        database->insertBirthday(birthday);
+        existing.insert({ birthday.date, birthday.name });
+    }
+}
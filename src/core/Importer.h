@@ -0,0 +1,46 @@
+#pragma once
+#include <QObject>
+#include <QHash>
+
+class QString;
+
+class NoteTaking;
+class Database;
+
+class Importer : public QObject {
+    Q_OBJECT
+public:
+    static void importAll(const QString& path, NoteTaking* noteTaking, Database* database, QWidget* parent);
+
+private:
+    struct Source {
+        QString path;
+        bool isZip = false;
+        QStringList dirs;
+        QStringList files;
+        // Name of an archive entry by its clean path.
+        QHash<QString, QString> zipEntries;
+    };
+
+    struct Node {
+        QString title;
+        QString filePath;
+        QString note;
+        bool markdown = false;
+        QVector<int> children;
+    };
+
+    static Source readDir(const QString& dirPath);
+    static Source readZip(const QString& filePath);
+    static QByteArray fileData(const Source& source, const QString& filePath);
+    static QString rootPrefix(const Source& source);
+    static bool isExported(const Source& source, const QString& prefix);
+
+    static QVector<Node> buildTree(const Source& source, const QString& prefix, QStringList& skippedFiles);
+    static int ensureNode(const QString& key, QHash<QString, int>& keys, QVector<Node>& nodes);
+    static void sortChildren(QVector<Node>& nodes);
+    static void loadNotes(const Source& source, QVector<Node>& nodes);
+
+    static int insertTree(const QVector<Node>& nodes, Database* database);
+    static void importBirthdays(const QByteArray& data, Database* database);
+};
@@ -2,6 +2,7 @@
 #include "Globals.h"
 #include <QString>
 #include <QDate>
+#include <QVector>
 
 struct Note {
     Id id;
@@ -15,9 +16,42 @@ struct Note {
     bool markdown;
 };
 
+struct ChildNote {
+    Id id;
+    int pos;
+    QString title;
+    bool hasChildren;
+};
+
+struct EditorState {
+    QString note;
+    int line = 0;
+    bool markdown = false;
+    // Latest revision of the note, zero while its text was never changed.
+    Id revision = 0;
+};
+
+struct Revision {
+    Id id;
+    QString createdAt;
+    int size;
+    int storedSize;
+    bool keyframe;
+};
+
+struct TextMatch {
+    int offset;
+    int length;
+};
+
 struct FindNote {
     Id id;
     QString title;
+    QString snippet;
+    QString matchText;
+    QVector<TextMatch> matches;
+    int matchCount = 0;
+    int score = 0;
 };
 
 struct Birthday {
@@ -2,13 +2,48 @@
 #include "Migrater.h"
 #include "DatabaseException.h"
 #include <QFileInfo>
+#include <QDataStream>
+#include <QCryptographicHash>
+#include <QtEndian>
 
 constexpr auto BirthdayDateFormat = "yyyy-MM-dd";
+constexpr auto CompressionThreshold = 64 * 1024;
+constexpr auto CompressionBatchSize = 100;
+constexpr auto KeyframeInterval = 16;
+constexpr auto RevisionCompressionThreshold = 1024;
+constexpr auto DataStreamVersion = QDataStream::Qt_6_0;
+
+static qint64 revisionChecksum(const QString& text) {
+    // Stored in the file, so unlike qHash it must not depend on the Qt version or the machine.
+    QByteArray hash = QCryptographicHash::hash(text.toUtf8(), QCryptographicHash::Sha1);
+    return qFromBigEndian<qint64>(hash.constData());
+}
+
+static QByteArray encodeRevision(const QByteArray& data, bool& compressed) {
+    compressed = false;
+
+    if (data.size() < RevisionCompressionThreshold) {
+        return data;
+    }
+
+    QByteArray compressedData = qCompress(data);
+
+    if (compressedData.size() >= data.size()) {
+        return data;
+    }
+
+    compressed = true;
+    return compressedData;
+}
 
 Database::Database(QObject* parent) : QObject(parent) {
     m_db = QSqlDatabase::addDatabase("QSQLITE");
 }
 
+Database::Database(const QSqlDatabase& db, QObject* parent) : QObject(parent), m_db(db) {
+
+}
+
 Database::~Database() {
     close();
 }
@@ -62,8 +97,24 @@ bool Database::isOpen() const {
     return m_db.isOpen();
 }
 
+void Database::transaction() {
+    if (!m_db.transaction()) {
+        throw DatabaseError(m_db.lastError());
+    }
+}
+
+void Database::commit() {
+    if (!m_db.commit()) {
+        throw DatabaseError(m_db.lastError());
+    }
+}
+
+void Database::rollback() {
+    m_db.rollback();
+}
+
 QSqlQuery Database::exec(const QString& sql, const QVariantMap& params) const {
-    QSqlQuery query;
+    QSqlQuery query(m_db);
     query.prepare(sql);
 
     for (auto it = params.cbegin(); it != params.cend(); it++) {
@@ -89,10 +140,94 @@ Id Database::insertNote(Id parentId, int pos, int depth, const QString& title) c
     return query.lastInsertId().toLongLong();
 }
 
+Ids Database::insertNotes(const QVector<Note>& notes) const {
+    QSqlQuery query(m_db);
+    query.prepare("INSERT INTO notes (parent_id, pos, depth, title, note, compressed, markdown) VALUES (:parent_id, :pos, :depth, :title, :note, :compressed, :markdown)");
+
+    Ids result;
+    result.reserve(notes.size());
+
+    for (const Note& note : notes) {
+        query.bindValue(":parent_id", note.parentId);
+        query.bindValue(":pos", note.pos);
+        query.bindValue(":depth", note.depth);
+        query.bindValue(":title", note.title);
+        bool compressed;
+        query.bindValue(":note", encodeNote(note.note, compressed));
+        query.bindValue(":compressed", compressed ? 1 : 0);
+        query.bindValue(":markdown", note.markdown ? 1 : 0);
+
+        if (!query.exec()) {
+            throw SqlQueryError(query);
+        }
+
+        result.append(query.lastInsertId().toLongLong());
+    }
+
+    return result;
+}
+
+void Database::updateNotes(const QVector<Note>& notes) const {
+    QSqlQuery query(m_db);
+    query.prepare("UPDATE notes SET title = :title, note = :note, compressed = :compressed, updated_at = datetime('now', 'localtime') WHERE id = :id");
+
+    for (const Note& note : notes) {
+        addRevision(note.id, noteValue(note.id, "note").toString(), note.note);
+
+        query.bindValue(":id", note.id);
+        query.bindValue(":title", note.title);
+        bool compressed;
+        query.bindValue(":note", encodeNote(note.note, compressed));
+        query.bindValue(":compressed", compressed ? 1 : 0);
+
+        if (!query.exec()) {
+            throw SqlQueryError(query);
+        }
+    }
+}
+
 void Database::removeNote(Id id) const {
+    exec("DELETE FROM revisions WHERE note_id = :id", { { "id", id } });
     exec("DELETE FROM notes WHERE id = :id", { { "id", id } });
 }
 
+Ids Database::removeSubtrees(const Ids& ids) {
+    const QString subtree =
+        "WITH RECURSIVE subtree(id) AS ("
+            "SELECT :id "
+            "UNION ALL "
+            "SELECT notes.id FROM notes JOIN subtree ON notes.parent_id = subtree.id"
+        ") ";
+
+    Ids result;
+    transaction();
+
+    try {
+        for (Id id : ids) {
+            QSqlQuery query = exec(subtree + "SELECT id FROM subtree", { { "id", id } });
+
+            while (query.next()) {
+                result.append(query.value(0).toLongLong());
+            }
+
+            exec(subtree + "DELETE FROM revisions WHERE note_id IN (SELECT id FROM subtree)", { { "id", id } });
+            exec(subtree + "DELETE FROM notes WHERE id IN (SELECT id FROM subtree)", { { "id", id } });
+        }
+
+        commit();
+    } catch (...) {
+        rollback();
+        throw;
+    }
+
+    return result;
+}
+
+int Database::childCount(Id parentId) const {
+    QSqlQuery query = exec("SELECT COUNT(*) FROM notes WHERE parent_id = :parent_id", { { "parent_id", parentId } });
+    return query.first() ? query.value(0).toInt() : 0;
+}
+
 Note Database::note(Id id) const {
     QSqlQuery query = exec("SELECT * FROM notes WHERE id = :id", { { "id", id } });
     query.next();
@@ -110,21 +245,318 @@ QVector<Note> Database::notes() const {
     return result;
 }
 
+QVector<Note> Database::noteHeaders() const {
+    QVector<Note> result;
+    QSqlQuery query = exec("SELECT id, parent_id, pos, depth, title, created_at, updated_at, markdown FROM notes ORDER BY depth, pos");
+
+    while (query.next()) {
+        Note note;
+        note.id = query.value(0).toLongLong();
+        note.parentId = query.value(1).toLongLong();
+        note.pos = query.value(2).toInt();
+        note.depth = query.value(3).toInt();
+        note.title = query.value(4).toString();
+        note.createdAt = query.value(5).toString();
+        note.updatedAt = query.value(6).toString();
+        note.markdown = query.value(7).toInt();
+
+        result.append(note);
+    }
+
+    return result;
+}
+
+QVector<ChildNote> Database::childNotes(Id parentId) const {
+    QVector<ChildNote> result;
+    QSqlQuery query = exec(
+        "SELECT id, pos, title, EXISTS(SELECT 1 FROM notes AS children WHERE children.parent_id = notes.id) "
+        "FROM notes WHERE parent_id = :parent_id ORDER BY pos", { { "parent_id", parentId } });
+
+    while (query.next()) {
+        ChildNote note;
+        note.id = query.value(0).toLongLong();
+        note.pos = query.value(1).toInt();
+        note.title = query.value(2).toString();
+        note.hasChildren = query.value(3).toBool();
+
+        result.append(note);
+    }
+
+    return result;
+}
+
+Ids Database::parentIds(Id id) const {
+    QSqlQuery query = exec(
+        "WITH RECURSIVE parents(id, parent_id, level) AS ("
+            "SELECT id, parent_id, 0 FROM notes WHERE id = :id "
+            "UNION ALL "
+            "SELECT notes.id, notes.parent_id, parents.level + 1 FROM notes JOIN parents ON notes.id = parents.parent_id"
+        ") "
+        "SELECT id FROM parents WHERE level > 0 ORDER BY level DESC", { { "id", id } });
+
+    Ids result;
+
+    while (query.next()) {
+        result.append(query.value(0).toLongLong());
+    }
+
+    return result;
+}
+
+int Database::lastPosition(Id parentId) const {
+    QSqlQuery query = exec("SELECT MAX(pos) FROM notes WHERE parent_id = :parent_id", { { "parent_id", parentId } });
+    return query.first() ? query.value(0).toInt() : 0;
+}
+
+void Database::updatePositions(const Ids& ids, const QVector<int>& positions) const {
+    QSqlQuery query(m_db);
+    query.prepare("UPDATE notes SET pos = :pos WHERE id = :id");
+
+    for (int i = 0; i < ids.size(); i++) {
+        query.bindValue(":id", ids.at(i));
+        query.bindValue(":pos", positions.at(i));
+
+        if (!query.exec()) {
+            throw SqlQueryError(query);
+        }
+    }
+}
+
+void Database::updateDepth(Id id, int depth) const {
+    // Depth of the note and all its descendants is rewritten in one statement.
+    exec("WITH RECURSIVE subtree(id, depth) AS ("
+             "SELECT :id, :depth "
+             "UNION ALL "
+             "SELECT notes.id, subtree.depth + 1 FROM notes JOIN subtree ON notes.parent_id = subtree.id"
+         ") "
+         "UPDATE notes SET depth = subtree.depth FROM subtree WHERE notes.id = subtree.id", { { "id", id }, { "depth", depth } });
+}
+
 void Database::updateNoteValue(Id id, const QString& name, const QVariant& value) const {
+    if (name == "note") {
+        addRevision(id, noteValue(id, "note").toString(), value.toString());
+        bool compressed;
+
+        QVariantMap params = {
+            { "id", id },
+            { "value", encodeNote(value.toString(), compressed) },
+            { "compressed", compressed ? 1 : 0 },
+        };
+
+        exec("UPDATE notes SET note = :value, compressed = :compressed, updated_at = datetime('now', 'localtime') WHERE id = :id", params);
+        return;
+    }
+
     QVariantMap params = {
         { "id", id },
         { "value", value },
     };
 
-    QString updateDate = name == "note" ? ", updated_at = datetime('now', 'localtime')" : "";
-    exec(QString("UPDATE notes SET %1 = :value %2 WHERE id = :id").arg(name, updateDate), params);
+    exec(QString("UPDATE notes SET %1 = :value WHERE id = :id").arg(name), params);
 }
 
 QVariant Database::noteValue(Id id, const QString& name) const {
+    if (name == "note") {
+        QSqlQuery query = exec("SELECT note, compressed FROM notes WHERE id = :id", { { "id", id } });
+        return query.first() ? decodeNote(query.value("note"), query.value("compressed").toBool()) : QVariant();
+    }
+
     QSqlQuery query = exec(QString("SELECT %1 FROM notes WHERE id = :id").arg(name), { { "id", id } });
     return query.first() ? query.value(name) : QVariant();
 }
 
+EditorState Database::editorState(Id id) const {
+    QSqlQuery query = exec("SELECT note, compressed, line, markdown, "
+                           "(SELECT MAX(id) FROM revisions WHERE note_id = notes.id) "
+                           "FROM notes WHERE id = :id", { { "id", id } });
+    EditorState result;
+
+    if (query.first()) {
+        result.note = decodeNote(query.value(0), query.value(1).toBool());
+        result.line = query.value(2).toInt();
+        result.markdown = query.value(3).toBool();
+        result.revision = query.value(4).toLongLong();
+    }
+
+    return result;
+}
+
+void Database::updateEditorState(Id id, const EditorState& state, bool noteChanged) const {
+    QVariantMap params = {
+        { "id", id },
+        { "line", state.line },
+        { "markdown", state.markdown ? 1 : 0 },
+    };
+
+    if (!noteChanged) {
+        exec("UPDATE notes SET line = :line, markdown = :markdown WHERE id = :id", params);
+        return;
+    }
+
+    addRevision(id, noteValue(id, "note").toString(), state.note);
+
+    bool compressed;
+    params["note"] = encodeNote(state.note, compressed);
+    params["compressed"] = compressed ? 1 : 0;
+
+    exec("UPDATE notes SET note = :note, compressed = :compressed, line = :line, markdown = :markdown, "
+         "updated_at = datetime('now', 'localtime') WHERE id = :id", params);
+}
+
+QVector<Revision> Database::revisions(Id noteId) const {
+    QSqlQuery query = exec("SELECT id, created_at, size, length(data), keyframe FROM revisions WHERE note_id = :note_id ORDER BY id DESC",
+                           { { "note_id", noteId } });
+    QVector<Revision> result;
+
+    while (query.next()) {
+        Revision revision;
+        revision.id = query.value(0).toLongLong();
+        revision.createdAt = query.value(1).toString();
+        revision.size = query.value(2).toInt();
+        revision.storedSize = query.value(3).toInt();
+        revision.keyframe = query.value(4).toBool();
+        result.append(revision);
+    }
+
+    return result;
+}
+
+QString Database::revisionText(Id revisionId) const {
+    // Text is rebuilt from the last keyframe at or before the revision and the deltas after it.
+    QSqlQuery query = exec(
+        "WITH target AS (SELECT id, note_id FROM revisions WHERE id = :id), "
+        "keyframe AS ("
+            "SELECT MAX(revisions.id) AS id FROM revisions, target "
+            "WHERE revisions.note_id = target.note_id AND revisions.keyframe = 1 AND revisions.id <= target.id"
+        ") "
+        "SELECT revisions.keyframe, revisions.compressed, revisions.data FROM revisions, target, keyframe "
+        "WHERE revisions.note_id = target.note_id AND revisions.id BETWEEN keyframe.id AND target.id "
+        "ORDER BY revisions.id", { { "id", revisionId } });
+
+    QString result;
+
+    while (query.next()) {
+        QByteArray data = query.value(2).toByteArray();
+
+        if (query.value(1).toBool()) {
+            data = qUncompress(data);
+        }
+
+        result = query.value(0).toBool() ? QString::fromUtf8(data) : applyDelta(result, data);
+    }
+
+    return result;
+}
+
+int Database::pruneRevisions(int days, int maxCount) {
+    // The latest revision of a note is always kept, older ones while they fit both limits.
+    QStringList limits;
+    QVariantMap params;
+
+    if (maxCount > 0) {
+        limits.append("number <= :count");
+        params["count"] = maxCount;
+    }
+
+    if (days > 0) {
+        limits.append("created_at >= datetime('now', 'localtime', :age)");
+        params["age"] = QString("-%1 days").arg(days);
+    }
+
+    if (limits.isEmpty()) return 0;
+
+    QSqlQuery query = exec(QString(
+        "SELECT note_id, MIN(id) FROM ("
+            "SELECT id, note_id, created_at, "
+            "ROW_NUMBER() OVER (PARTITION BY note_id ORDER BY id DESC) AS number, "
+            "MIN(id) OVER (PARTITION BY note_id) AS first "
+            "FROM revisions"
+        ") WHERE number = 1 OR (%1) "
+        "GROUP BY note_id HAVING MIN(id) > MIN(first)").arg(limits.join(" AND ")), params);
+
+    QVector<QPair<Id, Id>> cutoffs;
+
+    while (query.next()) {
+        cutoffs.append({ query.value(0).toLongLong(), query.value(1).toLongLong() });
+    }
+
+    int result = 0;
+    transaction();
+
+    try {
+        for (const auto& [noteId, revisionId] : cutoffs) {
+            // Oldest kept revision becomes a keyframe, deltas after it no longer need the removed ones.
+            QSqlQuery keyframeQuery = exec("SELECT keyframe FROM revisions WHERE id = :id", { { "id", revisionId } });
+
+            if (keyframeQuery.first() && !keyframeQuery.value(0).toBool()) {
+                bool compressed;
+
+                QVariantMap keyframeParams = {
+                    { "id", revisionId },
+                    { "data", encodeRevision(revisionText(revisionId).toUtf8(), compressed) },
+                    { "compressed", compressed ? 1 : 0 },
+                };
+
+                exec("UPDATE revisions SET keyframe = 1, compressed = :compressed, data = :data WHERE id = :id", keyframeParams);
+            }
+
+            QSqlQuery removeQuery = exec("DELETE FROM revisions WHERE note_id = :note_id AND id < :id",
+                                         { { "note_id", noteId }, { "id", revisionId } });
+            result += removeQuery.numRowsAffected();
+        }
+
+        // Revisions of notes removed before the cleanup on delete.
+        result += exec("DELETE FROM revisions WHERE note_id NOT IN (SELECT id FROM notes)").numRowsAffected();
+        commit();
+    } catch (...) {
+        rollback();
+        throw;
+    }
+
+    return result;
+}
+
+void Database::setCompressNotes(bool compress) {
+    m_compressNotes = compress;
+}
+
+int Database::compressNotes() {
+    if (!m_compressNotes) return 0;
+
+    QSqlQuery query = exec("SELECT id FROM notes WHERE compressed = 0 AND length(note) >= :threshold", { { "threshold", CompressionThreshold } });
+    Ids ids;
+
+    while (query.next()) {
+        ids.append(query.value(0).toLongLong());
+    }
+
+    int result = 0;
+
+    // Batches keep each write lock short, so the GUI connection is not blocked for the whole pass.
+    for (int i = 0; i < ids.size(); i += CompressionBatchSize) {
+        transaction();
+
+        try {
+            for (Id id : ids.mid(i, CompressionBatchSize)) {
+                bool compressed;
+                QVariant note = encodeNote(noteValue(id, "note").toString(), compressed);
+
+                if (compressed) {
+                    exec("UPDATE notes SET note = :note, compressed = 1 WHERE id = :id", { { "id", id }, { "note", note } });
+                    result++;
+                }
+            }
+
+            commit();
+        } catch (...) {
+            rollback();
+            throw;
+        }
+    }
+
+    return result;
+}
+
 Id Database::insertBirthday(const Birthday& birthday) const {
     QVariantMap params = {
         { "date", birthday.date.toString(BirthdayDateFormat) },
@@ -192,32 +624,15 @@ QVariant Database::metaValue(const QString& name) const {
     return query.first() ? query.value(name) : QVariant();
 }
 
-QVector<FindNote> Database::find(const QString& text) const {
-    QSqlQuery query = exec(QString("SELECT id, title, note FROM notes"));
-    QVector<FindNote> result;
-
-    while (query.next()) {
-        Id id = query.value("id").toInt();
-        QString title = query.value("title").toString();
-        QString note = query.value("note").toString();
-
-        if (title.contains(text, Qt::CaseInsensitive) || note.contains(text, Qt::CaseInsensitive)) {
-            FindNote findNote;
-            findNote.id = id;
-            findNote.title = parentPath(id);
-
-            result.append(findNote);
-        }
-    }
-
-    return result;
-}
-
 QString Database::name() const {
     QFileInfo fi(m_db.databaseName());
     return fi.baseName();
 }
 
+QString Database::filePath() const {
+    return m_db.databaseName();
+}
+
 Note Database::queryToNote(const QSqlQuery& query) const {
     Note result;
     result.id = query.value("id").toLongLong();
@@ -225,7 +640,7 @@ Note Database::queryToNote(const QSqlQuery& query) const {
     result.pos = query.value("pos").toInt();
     result.depth = query.value("depth").toInt();
     result.title = query.value("title").toString();
-    result.note = query.value("note").toString();
+    result.note = decodeNote(query.value("note"), query.value("compressed").toBool());
     result.createdAt = query.value("created_at").toString();
     result.updatedAt = query.value("updated_at").toString();
     result.markdown = query.value("markdown").toInt();
@@ -233,27 +648,117 @@ Note Database::queryToNote(const QSqlQuery& query) const {
     return result;
 }
 
-QString Database::parentPath(Id id) const {
-    Id parentId = id;
-    QStringList titles;
+QVariant Database::encodeNote(const QString& note, bool& compressed) const {
+    compressed = false;
 
-    while (parentId) {
-        QSqlQuery query = exec("SELECT title, parent_id FROM notes WHERE id = :id", { { "id", parentId } });
+    if (!m_compressNotes || note.size() < CompressionThreshold) {
+        return note;
+    }
 
-        if (!query.next()) {
-            break;
-        }
+    QByteArray data = note.toUtf8();
+    QByteArray compressedData = qCompress(data);
 
-        parentId = query.value("parent_id").toInt();
-        titles.append(query.value("title").toString());
+    // Stored as BLOB, so SQLite keeps the bytes as is in the TEXT column.
+    if (compressedData.size() >= data.size()) {
+        return note;
     }
 
-    QString result;
+    compressed = true;
+    return compressedData;
+}
+
+void Database::addRevision(Id noteId, const QString& previous, const QString& note) const {
+    if (note == previous) return;
+
+    QSqlQuery query = exec("SELECT keyframe, checksum FROM revisions WHERE note_id = :note_id ORDER BY id DESC LIMIT :limit",
+                           { { "note_id", noteId }, { "limit", KeyframeInterval } });
+
+    // History continues from the last revision only while it matches the stored note.
+    bool continued = query.next() && query.value(1).toLongLong() == revisionChecksum(previous);
+    int deltaCount = 0;
+
+    if (continued) {
+        do {
+            if (query.value(0).toBool()) break;
+            deltaCount++;
+        } while (query.next());
+    } else if (!previous.isEmpty()) {
+        insertRevision(noteId, previous, previous.toUtf8(), true);
+        continued = true;
+    }
+
+    if (continued && deltaCount < KeyframeInterval) {
+        QByteArray delta = encodeSmallDelta(previous, note);
 
-    for (const auto& title : titles) {
-        result.prepend(title + " > ");
+        if (!delta.isEmpty()) {
+            insertRevision(noteId, note, delta, false);
+            return;
+        }
+    }
+
+    insertRevision(noteId, note, note.toUtf8(), true);
+}
+
+void Database::insertRevision(Id noteId, const QString& text, const QByteArray& data, bool keyframe) const {
+    bool compressed;
+
+    QVariantMap params = {
+        { "note_id", noteId },
+        { "keyframe", keyframe ? 1 : 0 },
+        { "data", encodeRevision(data, compressed) },
+        { "compressed", compressed ? 1 : 0 },
+        { "size", text.size() },
+        { "checksum", revisionChecksum(text) },
+    };
+
+    exec("INSERT INTO revisions (note_id, keyframe, compressed, data, size, checksum) "
+         "VALUES (:note_id, :keyframe, :compressed, :data, :size, :checksum)", params);
+}
+
+QByteArray Database::encodeDelta(const QString& base, const QString& text) {
+    int length = int(qMin(base.size(), text.size()));
+    int prefix = 0;
+    int suffix = 0;
+
+    while (prefix < length && base.at(prefix) == text.at(prefix)) {
+        prefix++;
+    }
+
+    while (suffix < length - prefix && base.at(base.size() - suffix - 1) == text.at(text.size() - suffix - 1)) {
+        suffix++;
     }
 
-    result.chop(3);
+    return encodeDelta(prefix, suffix, text.mid(prefix, text.size() - prefix - suffix));
+}
+
+QByteArray Database::encodeDelta(int prefix, int suffix, const QString& middle) {
+    QByteArray result;
+    QDataStream stream(&result, QIODevice::WriteOnly);
+    stream.setVersion(DataStreamVersion);
+    stream << qint32(prefix) << qint32(suffix) << middle;
+
     return result;
 }
+
+QByteArray Database::encodeSmallDelta(const QString& base, const QString& text) {
+    QByteArray result = encodeDelta(base, text);
+
+    // Changed text is stored in UTF-16, so it is a delta while it is under half of the text.
+    return result.size() < text.size() ? result : QByteArray();
+}
+
+QString Database::applyDelta(const QString& base, const QByteArray& delta) {
+    qint32 prefix;
+    qint32 suffix;
+    QString middle;
+
+    QDataStream stream(delta);
+    stream.setVersion(DataStreamVersion);
+    stream >> prefix >> suffix >> middle;
+
+    return base.left(prefix) + middle + base.right(suffix);
+}
+
+QString Database::decodeNote(const QVariant& value, bool compressed) {
+    return compressed ? QString::fromUtf8(qUncompress(value.toByteArray())) : value.toString();
+}
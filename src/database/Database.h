@@ -5,7 +5,12 @@
 
 class Database : public QObject {
 public:
+    // Sibling positions are spaced, so that a note is placed between two others with one write.
+    static constexpr int PositionGap = 1024;
+
     explicit Database(QObject* parent = nullptr);
+    // Works with a connection opened by the caller, e.g. on a worker thread.
+    explicit Database(const QSqlDatabase& db, QObject* parent = nullptr);
     ~Database() override;
 
     void create(const QString& filepath);
@@ -13,16 +18,40 @@ public:
     void close();
     bool isOpen() const;
 
+    void transaction();
+    void commit();
+    void rollback();
+
     QSqlQuery exec(const QString& sql, const QVariantMap& params = QVariantMap()) const;
 
     Id insertNote(Id parentId, int pos, int depth, const QString& title) const;
+    Ids insertNotes(const QVector<Note>& notes) const;
+    void updateNotes(const QVector<Note>& notes) const;
     void removeNote(Id id) const;
+    Ids removeSubtrees(const Ids& ids);
+    int childCount(Id parentId) const;
     Note note(Id id) const;
     QVector<Note> notes() const;
+    QVector<Note> noteHeaders() const;
+    QVector<ChildNote> childNotes(Id parentId) const;
+    Ids parentIds(Id id) const;
+    int lastPosition(Id parentId) const;
+    void updatePositions(const Ids& ids, const QVector<int>& positions) const;
+    void updateDepth(Id id, int depth) const;
 
     void updateNoteValue(Id id, const QString& name, const QVariant& value) const;
     QVariant noteValue(Id id, const QString& name) const;
 
+    EditorState editorState(Id id) const;
+    void updateEditorState(Id id, const EditorState& state, bool noteChanged) const;
+
+    QVector<Revision> revisions(Id noteId) const;
+    QString revisionText(Id revisionId) const;
+    int pruneRevisions(int days, int maxCount);
+
+    void setCompressNotes(bool compress);
+    int compressNotes();
+
     Id insertBirthday(const Birthday& birthday) const;
     void updateBirthday(const Birthday& birthday) const;
     void removeBirthday(Id id) const;
@@ -32,13 +61,26 @@ public:
     void updateMetaValue(const QString& name, const QVariant& value) const;
     QVariant metaValue(const QString& name) const;
 
-    QVector<FindNote> find(const QString& text) const;
-
     QString name() const;
+    QString filePath() const;
+
+    static QString decodeNote(const QVariant& value, bool compressed);
+
+    // Delta replaces the text between the common prefix and suffix of two versions.
+    static QByteArray encodeDelta(const QString& base, const QString& text);
+    static QByteArray encodeDelta(int prefix, int suffix, const QString& middle);
+    // Empty when the text is mostly rewritten and is smaller stored whole.
+    static QByteArray encodeSmallDelta(const QString& base, const QString& text);
+    static QString applyDelta(const QString& base, const QByteArray& delta);
 
 private:
     Note queryToNote(const QSqlQuery& query) const;
-    QString parentPath(Id id) const;
+
+    QVariant encodeNote(const QString& note, bool& compressed) const;
+
+    void addRevision(Id noteId, const QString& previous, const QString& note) const;
+    void insertRevision(Id noteId, const QString& text, const QByteArray& data, bool keyframe) const;
 
     QSqlDatabase m_db;
+    bool m_compressNotes = true;
 };
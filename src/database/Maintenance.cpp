@@ -0,0 +1,131 @@
+#include "Maintenance.h"
+#include "Database.h"
+#include "core/Exception.h"
+#include <QtConcurrent>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QElapsedTimer>
+
+constexpr auto ConnectionName = "maintenance";
+constexpr auto AnalysisLimit = 1000;
+constexpr auto IncrementalVacuum = 2;
+
+Maintenance::Maintenance(QObject* parent) : QObject(parent) {
+    connect(&m_watcher, &QFutureWatcher<QVector<Task>>::finished, this, [this] {
+        m_tasks = m_watcher.result();
+        m_finishedAt = QDateTime::currentDateTime();
+        emit finished();
+    });
+}
+
+void Maintenance::setOptions(const Options& options) {
+    m_options = options;
+}
+
+void Maintenance::run(const QString& filePath) {
+    if (isRunning() || filePath.isEmpty()) return;
+
+    qInfo().noquote() << "Run database maintenance:" << filePath;
+    m_watcher.setFuture(QtConcurrent::run(&Maintenance::exec, filePath, m_options));
+    emit started();
+}
+
+bool Maintenance::isRunning() const {
+    return m_watcher.isRunning();
+}
+
+QVector<Maintenance::Task> Maintenance::tasks() const {
+    return m_tasks;
+}
+
+QDateTime Maintenance::finishedAt() const {
+    return m_finishedAt;
+}
+
+QVector<Maintenance::Task> Maintenance::exec(const QString& filePath, const Options& options) {
+    QVector<Task> result;
+
+    {
+        // Own connection, so the GUI thread keeps working with the database.
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", ConnectionName);
+        db.setDatabaseName(filePath);
+        db.setConnectOptions("QSQLITE_BUSY_TIMEOUT=10000");
+
+        if (!db.open()) {
+            result.append({ tr("Open"), db.lastError().text() });
+        } else {
+            auto measure = [&] (const QString& name, const std::function<QString()>& task) {
+                QElapsedTimer timer;
+                timer.start();
+
+                QString value = task();
+                result.append({ name, value, timer.elapsed() });
+            };
+
+            auto run = [&] (const QString& name, const QString& sql) {
+                measure(name, [&] {
+                    QSqlQuery query(db);
+                    QStringList values;
+
+                    if (query.exec(sql)) {
+                        while (query.next()) {
+                            values.append(query.value(0).toString());
+                        }
+                    } else {
+                        values.append(query.lastError().text());
+                    }
+
+                    return values.join("; ");
+                });
+            };
+
+            Database database(db);
+            database.setCompressNotes(options.compressNotes);
+
+            measure(tr("Compress notes"), [&] {
+                try {
+                    return QString::number(database.compressNotes());
+                } catch (const Exception& e) {
+                    return e.error();
+                }
+            });
+
+            measure(tr("Prune history"), [&] {
+                try {
+                    return QString::number(database.pruneRevisions(options.historyDays, options.historyRevisions));
+                } catch (const Exception& e) {
+                    return e.error();
+                }
+            });
+
+            QSqlQuery(db).exec(QString("PRAGMA analysis_limit = %1").arg(AnalysisLimit));
+
+            QSqlQuery autoVacuumQuery(db);
+
+            if (autoVacuumQuery.exec("PRAGMA auto_vacuum") && autoVacuumQuery.first()
+                    && autoVacuumQuery.value(0).toInt() != IncrementalVacuum) {
+                autoVacuumQuery.finish();
+                // Switching auto_vacuum mode takes effect only after a full VACUUM,
+                // which rewrites the whole file, so it is done once here instead of on open.
+                QSqlQuery(db).exec("PRAGMA auto_vacuum = INCREMENTAL");
+                run(tr("Full vacuum"), "VACUUM");
+            }
+
+            run(tr("Free pages"), "PRAGMA freelist_count");
+            run(tr("Incremental vacuum"), "PRAGMA incremental_vacuum");
+            run(tr("Free pages"), "PRAGMA freelist_count");
+            run(tr("Analyze"), "ANALYZE");
+            run(tr("Optimize"), "PRAGMA optimize");
+            run(tr("Quick check"), "PRAGMA quick_check");
+
+            QSqlQuery(db).exec("UPDATE meta SET maintained_at = datetime('now', 'localtime')");
+
+            db.close();
+        }
+    }
+
+    QSqlDatabase::removeDatabase(ConnectionName);
+
+    return result;
+}
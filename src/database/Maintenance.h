@@ -0,0 +1,41 @@
+#pragma once
+#include <QObject>
+#include <QDateTime>
+#include <QFutureWatcher>
+
+class Maintenance : public QObject {
+    Q_OBJECT
+public:
+    struct Task {
+        QString name;
+        QString result;
+        qint64 elapsed = 0;
+    };
+
+    struct Options {
+        bool compressNotes = true;
+        int historyDays = 0;
+        int historyRevisions = 0;
+    };
+
+    explicit Maintenance(QObject* parent = nullptr);
+
+    void setOptions(const Options& options);
+    void run(const QString& filePath);
+    bool isRunning() const;
+
+    QVector<Task> tasks() const;
+    QDateTime finishedAt() const;
+
+signals:
+    void started();
+    void finished();
+
+private:
+    static QVector<Task> exec(const QString& filePath, const Options& options);
+
+    QFutureWatcher<QVector<Task>> m_watcher;
+    Options m_options;
+    QVector<Task> m_tasks;
+    QDateTime m_finishedAt;
+};
@@ -2,12 +2,17 @@
 #include "Database.h"
 #include <QSqlQuery>
 
-constexpr auto currentVersion = 4;
+constexpr auto currentVersion = 9;
 
 Migrater::Migrater(Database* db) : m_db(db) {
     migrations[2] = [this] { migration2(); };
     migrations[3] = [this] { migration3(); };
     migrations[4] = [this] { migration4(); };
+    migrations[5] = [this] { migration5(); };
+    migrations[6] = [this] { migration6(); };
+    migrations[7] = [this] { migration7(); };
+    migrations[8] = [this] { migration8(); };
+    migrations[9] = [this] { migration9(); };
 }
 
 void Migrater::run() const {
@@ -40,3 +45,42 @@ void Migrater::migration3() const {
 void Migrater::migration4() const {
     m_db->exec("ALTER TABLE notes ADD COLUMN markdown BOOLEAN NOT NULL DEFAULT 0");
 }
+
+void Migrater::migration5() const {
+    // Existing notes are compressed by the maintenance, if the setting allows it.
+    m_db->exec("ALTER TABLE notes ADD COLUMN compressed BOOLEAN NOT NULL DEFAULT 0");
+}
+
+void Migrater::migration6() const {
+    // Incremental auto_vacuum is enabled by the maintenance, its full VACUUM would block opening a large file.
+    m_db->exec("ALTER TABLE meta ADD COLUMN maintained_at TIMESTAMP");
+}
+
+void Migrater::migration7() const {
+    m_db->exec("CREATE INDEX notes_parent_id_pos ON notes(parent_id, pos)");
+    m_db->exec("CREATE INDEX notes_depth_pos ON notes(depth, pos)");
+    m_db->exec("CREATE INDEX notes_updated_at ON notes(updated_at)");
+    m_db->exec("CREATE INDEX birthdays_month_day ON birthdays(strftime('%m-%d', date))");
+}
+
+void Migrater::migration8() const {
+    // Positions were consecutive, gaps let notes be placed between siblings without renumbering.
+    m_db->exec("UPDATE notes SET pos = (pos + 1) * :gap", { { "gap", Database::PositionGap } });
+}
+
+void Migrater::migration9() const {
+    m_db->exec(
+        "CREATE TABLE revisions("
+            "id INTEGER PRIMARY KEY AUTOINCREMENT,"
+            "note_id INTEGER,"
+            "created_at TIMESTAMP DEFAULT (datetime('now', 'localtime')),"
+            "keyframe BOOLEAN NOT NULL DEFAULT 0,"
+            "compressed BOOLEAN NOT NULL DEFAULT 0,"
+            "data BLOB,"
+            "size INTEGER,"
+            "checksum INTEGER"
+        ")"
+    );
+
+    m_db->exec("CREATE INDEX revisions_note_id ON revisions(note_id, id)");
+}
@@ -12,6 +12,11 @@ private:
     void migration2() const; // 14.12.2019
     void migration3() const; // 09.12.2023
     void migration4() const; // 24.10.2023
+    void migration5() const; // 19.10.2026
+    void migration6() const; // 19.10.2026
+    void migration7() const; // 19.10.2026
+    void migration8() const; // 19.10.2026
+    void migration9() const; // 19.10.2026
 
     Database* m_db = nullptr;
     QHash<int, std::function<void()>> migrations;
@@ -0,0 +1,198 @@
+#include "RecoveryJournal.h"
+#include "Database.h"
+#include <QDataStream>
+#include <QDebug>
+
+constexpr auto FileSuffix = ".recovery";
+constexpr auto DataStreamVersion = QDataStream::Qt_6_0;
+
+RecoveryJournal::RecoveryJournal(QObject* parent) : QObject(parent) {
+    // One writer keeps the records in the order they were appended.
+    m_pool.setMaxThreadCount(1);
+}
+
+RecoveryJournal::~RecoveryJournal() {
+    close();
+}
+
+void RecoveryJournal::open(const QString& databasePath) {
+    close();
+
+    // Previous journal is either replayed or discarded before the database is opened.
+    m_filePath = filePath(databasePath);
+    QFile::remove(m_filePath);
+    m_file.setFileName(m_filePath);
+}
+
+void RecoveryJournal::close() {
+    m_pool.waitForDone();
+
+    if (m_filePath.isEmpty()) return;
+
+    m_file.close();
+
+    // Text of notes that were not saved is kept for the next start.
+    if (m_notes.isEmpty() && m_changes.isEmpty()) {
+        QFile::remove(m_filePath);
+    }
+
+    m_notes.clear();
+    m_changes.clear();
+    m_filePath.clear();
+}
+
+void RecoveryJournal::append(Id id, const QString& note) {
+    if (m_filePath.isEmpty()) return;
+
+    m_pool.start([this, id, note] {
+        auto it = m_notes.find(id);
+
+        if (it == m_notes.end()) {
+            write(RecordType::Note, id, note.toUtf8());
+            m_notes.insert(id, note);
+            m_changes.remove(id);
+            return;
+        }
+
+        if (it.value() == note) return;
+
+        QByteArray delta = Database::encodeSmallDelta(it.value(), note);
+
+        if (!delta.isEmpty()) {
+            write(RecordType::Delta, id, delta);
+        } else {
+            write(RecordType::Note, id, note.toUtf8());
+        }
+
+        it.value() = note;
+    });
+}
+
+void RecoveryJournal::appendChange(Id id, int baseSize, int prefix, int suffix, const QString& text) {
+    if (m_filePath.isEmpty()) return;
+
+    m_pool.start([this, id, baseSize, prefix, suffix, text] {
+        QByteArray data;
+        QDataStream stream(&data, QIODevice::WriteOnly);
+        stream.setVersion(DataStreamVersion);
+        stream << qint32(baseSize) << Database::encodeDelta(prefix, suffix, text);
+
+        if (m_changes.value(id) == data) return;
+
+        write(RecordType::Change, id, data);
+        m_notes.remove(id);
+        m_changes.insert(id, data);
+    });
+}
+
+void RecoveryJournal::markSaved(Id id) {
+    if (m_filePath.isEmpty()) return;
+
+    m_pool.start([this, id] {
+        if (!m_notes.remove(id) && !m_changes.remove(id)) return;
+
+        // Journal is emptied once all its notes are saved, so it does not grow over the session.
+        if (m_notes.isEmpty() && m_changes.isEmpty()) {
+            m_file.resize(0);
+        } else {
+            write(RecordType::Saved, id, QByteArray());
+        }
+    });
+}
+
+QVector<RecoveryJournal::Entry> RecoveryJournal::read(const QString& databasePath) {
+    QFile file(filePath(databasePath));
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        return {};
+    }
+
+    QHash<Id, QString> notes;
+    QHash<Id, QByteArray> changes;
+    Ids ids;
+    QDataStream stream(&file);
+    stream.setVersion(DataStreamVersion);
+
+    while (!stream.atEnd()) {
+        QByteArray record;
+        quint16 checksum;
+        stream >> record >> checksum;
+
+        // Record torn by a crash ends the journal.
+        if (stream.status() != QDataStream::Ok || checksum != qChecksum(record)) break;
+
+        quint8 type;
+        qint64 id;
+        QByteArray data;
+
+        QDataStream recordStream(record);
+        recordStream.setVersion(DataStreamVersion);
+        recordStream >> type >> id >> data;
+
+        switch (RecordType(type)) {
+            case RecordType::Note:
+                if (!ids.contains(id)) ids.append(id);
+                notes[id] = QString::fromUtf8(data);
+                changes.remove(id);
+                break;
+            case RecordType::Delta:
+                if (notes.contains(id)) notes[id] = Database::applyDelta(notes.value(id), data);
+                break;
+            case RecordType::Saved:
+                notes.remove(id);
+                changes.remove(id);
+                ids.removeOne(id);
+                break;
+            case RecordType::Change:
+                if (!ids.contains(id)) ids.append(id);
+                notes.remove(id);
+                changes[id] = data;
+                break;
+        }
+    }
+
+    QVector<Entry> result;
+
+    for (Id id : std::as_const(ids)) {
+        if (!changes.contains(id)) {
+            result.append({ id, notes.value(id) });
+            continue;
+        }
+
+        QDataStream changeStream(changes.value(id));
+        changeStream.setVersion(DataStreamVersion);
+
+        Entry entry { id, QString() };
+        qint32 baseSize;
+        changeStream >> baseSize >> entry.change;
+        entry.baseSize = baseSize;
+        result.append(entry);
+    }
+
+    return result;
+}
+
+QString RecoveryJournal::filePath(const QString& databasePath) {
+    return databasePath + FileSuffix;
+}
+
+void RecoveryJournal::write(RecordType type, Id id, const QByteArray& data) {
+    if (!m_file.isOpen() && !m_file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qCritical().noquote() << "Failed to open recovery journal:" << m_file.errorString();
+        return;
+    }
+
+    QByteArray record;
+    QDataStream recordStream(&record, QIODevice::WriteOnly);
+    recordStream.setVersion(DataStreamVersion);
+    recordStream << quint8(type) << qint64(id) << data;
+
+    QByteArray frame;
+    QDataStream frameStream(&frame, QIODevice::WriteOnly);
+    frameStream.setVersion(DataStreamVersion);
+    frameStream << record << quint16(qChecksum(record));
+
+    // Whole record goes in one append, so a crash can leave only the last one incomplete.
+    m_file.write(frame);
+    m_file.flush();
+}
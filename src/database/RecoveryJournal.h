@@ -0,0 +1,50 @@
+#pragma once
+#include "core/Globals.h"
+#include <QObject>
+#include <QThreadPool>
+#include <QFile>
+#include <QHash>
+
+// Appends unsaved editor text to a file next to the database, so that it survives a crash until the note is saved.
+class RecoveryJournal : public QObject {
+    Q_OBJECT
+public:
+    struct Entry {
+        Id id;
+        QString note;
+        // Change of a large note is a delta against its stored text of the given size.
+        QByteArray change;
+        int baseSize = 0;
+    };
+
+    explicit RecoveryJournal(QObject* parent = nullptr);
+    ~RecoveryJournal() override;
+
+    void open(const QString& databasePath);
+    void close();
+
+    void append(Id id, const QString& note);
+    void appendChange(Id id, int baseSize, int prefix, int suffix, const QString& text);
+    void markSaved(Id id);
+
+    static QVector<Entry> read(const QString& databasePath);
+    static QString filePath(const QString& databasePath);
+
+private:
+    enum class RecordType : quint8 {
+        Note,
+        Delta,
+        Saved,
+        Change
+    };
+
+    void write(RecordType type, Id id, const QByteArray& data);
+
+    QString m_filePath;
+
+    // Used by the writer thread, or after it is done.
+    QThreadPool m_pool;
+    QFile m_file;
+    QHash<Id, QString> m_notes;
+    QHash<Id, QByteArray> m_changes;
+};
@@ -0,0 +1,325 @@
+#include "Search.h"
+#include "Database.h"
+#include <QtConcurrent>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QRegularExpression>
+#include <numeric>
+
+constexpr auto MaxMatches = 100;
+constexpr auto SnippetContext = 40;
+constexpr auto BatchSize = 256;
+
+Search::Search(QObject* parent) : QObject(parent) {
+    connect(&m_watcher, &QFutureWatcher<FindNote>::resultsReadyAt, this, [this] (int begin, int end) {
+        QVector<FindNote> notes;
+
+        for (int i = begin; i < end; i++) {
+            notes.append(m_watcher.resultAt(i));
+        }
+
+        emit found(notes);
+    });
+
+    connect(&m_watcher, &QFutureWatcher<FindNote>::finished, this, [this] {
+        if (m_watcher.isCanceled()) return;
+        emit finished(m_watcher.future().resultCount(), m_timer.elapsed());
+    });
+}
+
+Search::~Search() {
+    cancel();
+}
+
+void Search::start(const QString& filePath, const Options& options) {
+    // Superseded search stops at the next batch, its results are not delivered.
+    cancel();
+
+    m_timer.start();
+    m_watcher.setFuture(QtConcurrent::run(&Search::exec, filePath, options));
+}
+
+void Search::cancel() {
+    m_watcher.cancel();
+}
+
+bool Search::isRunning() const {
+    return m_watcher.isRunning();
+}
+
+QRegularExpression Search::regularExpression(const Options& options) {
+    QString pattern = options.regex ? options.text : QRegularExpression::escape(options.text);
+
+    if (options.wholeWords) {
+        pattern = "\\b(?:" + pattern + ")\\b";
+    }
+
+    QRegularExpression::PatternOptions patternOptions = QRegularExpression::UseUnicodePropertiesOption;
+
+    if (!options.caseSensitive) {
+        patternOptions |= QRegularExpression::CaseInsensitiveOption;
+    }
+
+    return QRegularExpression(pattern, patternOptions);
+}
+
+int Search::replace(const Ids& ids, const Options& options, const QString& replacement, Database* database, QVector<Note>& notes) {
+    // Literal patterns are escaped without capture groups, so their replacement has no backreferences to expand.
+    QRegularExpression regex = regularExpression(options);
+    regex.optimize();
+
+    notes.clear();
+
+    for (Id id : ids) {
+        notes.append(database->note(id));
+    }
+
+    QVector<int> counts(notes.count());
+    const Note* first = notes.constData();
+
+    QtConcurrent::blockingMap(notes, [&] (Note& note) {
+        int index = &note - first;
+
+        if (options.field != Field::Note) {
+            counts[index] += count(regex, note.title);
+            note.title.replace(regex, replacement);
+        }
+
+        if (options.field != Field::Title) {
+            counts[index] += count(regex, note.note);
+            note.note.replace(regex, replacement);
+        }
+    });
+
+    database->transaction();
+
+    try {
+        database->updateNotes(notes);
+        database->commit();
+    } catch (...) {
+        database->rollback();
+        throw;
+    }
+
+    return std::accumulate(counts.cbegin(), counts.cend(), 0);
+}
+
+void Search::exec(QPromise<FindNote>& promise, const QString& filePath, const Options& options) {
+    QRegularExpression regex = regularExpression(options);
+
+    if (!regex.isValid()) return;
+
+    // Compile with JIT once, before the pattern is shared between the verifying threads.
+    regex.optimize();
+
+    // Own connection per worker thread, so the GUI thread keeps working with the database.
+    QString connectionName = QString("search-%1").arg(quintptr(QThread::currentThreadId()));
+
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+        db.setDatabaseName(filePath);
+        db.setConnectOptions("QSQLITE_OPEN_READONLY;QSQLITE_BUSY_TIMEOUT=10000");
+
+        if (!db.open()) {
+            qCritical().noquote() << "Error open search connection:" << db.lastError().text();
+        } else {
+            QHash<Id, std::pair<Id, QString>> headers;
+
+            QSqlQuery query(db);
+            query.setForwardOnly(true);
+            query.exec("SELECT id, parent_id, title FROM notes");
+
+            while (query.next()) {
+                headers[query.value(0).toLongLong()] = { query.value(1).toLongLong(), query.value(2).toString() };
+            }
+
+            auto path = [&] (Id id) {
+                QStringList titles;
+
+                for (auto it = headers.constFind(id); it != headers.cend(); it = headers.constFind(it->first)) {
+                    titles.prepend(it->second);
+                }
+
+                return titles.join(" > ");
+            };
+
+            QVector<Candidate> batch;
+
+            auto verify = [&] {
+                QtConcurrent::blockingMap(batch, [&] (Candidate& candidate) {
+                    if (promise.isCanceled()) return;
+
+                    QString note = Database::decodeNote(candidate.note, candidate.compressed);
+                    candidate.matched = match(regex, options, candidate.title, note, candidate.findNote);
+                });
+
+                for (Candidate& candidate : batch) {
+                    if (!candidate.matched) continue;
+
+                    candidate.findNote.id = candidate.id;
+                    candidate.findNote.title = path(candidate.id);
+                    promise.addResult(candidate.findNote);
+                }
+
+                batch.clear();
+            };
+
+            QVariantMap params;
+            query.prepare(candidatesSql(options, params));
+
+            for (auto it = params.cbegin(); it != params.cend(); it++) {
+                query.bindValue(":" + it.key(), it.value());
+            }
+
+            if (!query.exec()) {
+                qCritical().noquote() << "Error search notes:" << query.lastError().text();
+            }
+
+            while (query.next() && !promise.isCanceled()) {
+                Candidate candidate;
+                candidate.id = query.value(0).toLongLong();
+                candidate.title = query.value(1).toString();
+                candidate.note = query.value(2);
+                candidate.compressed = query.value(3).toBool();
+                batch.append(candidate);
+
+                if (batch.count() == BatchSize) {
+                    verify();
+                }
+            }
+
+            if (!promise.isCanceled()) {
+                verify();
+            }
+
+            query.finish();
+            db.close();
+        }
+    }
+
+    QSqlDatabase::removeDatabase(connectionName);
+}
+
+QString Search::candidatesSql(const Options& options, QVariantMap& params) {
+    QString columns = options.field == Field::Title ? "id, title, '', 0" : "id, title, note, compressed";
+    QString sql = QString("SELECT %1 FROM notes").arg(columns);
+    QStringList conditions;
+
+    if (options.rootId) {
+        sql.prepend("WITH RECURSIVE subtree(id) AS (SELECT :root_id UNION ALL "
+                    "SELECT notes.id FROM notes JOIN subtree ON notes.parent_id = subtree.id) ");
+        conditions.append("id IN (SELECT id FROM subtree)");
+        params["root_id"] = options.rootId;
+    }
+
+    // LIKE ignores case of ASCII letters only, so it narrows down literal searches
+    // without losing matches. Compressed notes can't be checked by SQLite.
+    bool ascii = std::all_of(options.text.cbegin(), options.text.cend(), [] (QChar c) {
+        return c.unicode() < 128;
+    });
+
+    if (!options.regex && (ascii || options.caseSensitive)) {
+        QString pattern = options.text;
+        pattern.replace("\\", "\\\\").replace("%", "\\%").replace("_", "\\_");
+        params["pattern"] = "%" + pattern + "%";
+
+        QString title = "title LIKE :pattern ESCAPE '\\'";
+        QString note = "compressed = 1 OR note LIKE :pattern ESCAPE '\\'";
+
+        switch (options.field) {
+            case Field::All: conditions.append(QString("(%1 OR %2)").arg(title, note)); break;
+            case Field::Title: conditions.append(title); break;
+            case Field::Note: conditions.append(QString("(%1)").arg(note)); break;
+        }
+    }
+
+    if (!conditions.isEmpty()) {
+        sql += " WHERE " + conditions.join(" AND ");
+    }
+
+    return sql;
+}
+
+bool Search::match(const QRegularExpression& regex, const Options& options, const QString& title, const QString& note, FindNote& findNote) {
+    int titleOffset = options.field == Field::Note ? -1 : title.indexOf(regex);
+
+    if (options.countAll && titleOffset >= 0) {
+        findNote.matchCount += count(regex, title);
+    }
+
+    if (options.field != Field::Title) {
+        // Offsets are collected once here, so opening the note needs no second scan.
+        QRegularExpressionMatchIterator it = regex.globalMatch(note);
+
+        while (it.hasNext() && (options.countAll || findNote.matches.count() < MaxMatches)) {
+            QRegularExpressionMatch regexMatch = it.next();
+
+            if (regexMatch.capturedLength() > 0) {
+                findNote.matchCount++;
+
+                if (findNote.matches.count() < MaxMatches) {
+                    findNote.matches.append({ int(regexMatch.capturedStart()), int(regexMatch.capturedLength()) });
+                }
+            }
+        }
+    }
+
+    if (titleOffset < 0 && findNote.matches.isEmpty()) {
+        return false;
+    }
+
+    // Title hits go first, then notes with more and earlier matches.
+    int score = 0;
+
+    if (titleOffset == 0) {
+        score += 2000;
+    } else if (titleOffset > 0) {
+        score += 1000;
+    }
+
+    if (!findNote.matches.isEmpty()) {
+        const TextMatch& first = findNote.matches.constFirst();
+        score += findNote.matches.count() * 10;
+        score += qMax(0, 100 - first.offset / 100);
+
+        findNote.matchText = note.mid(first.offset, first.length);
+        findNote.snippet = snippet(note, first.offset, first.length);
+    } else {
+        findNote.snippet = snippet(note, 0, 0);
+    }
+
+    findNote.score = score;
+
+    return true;
+}
+
+int Search::count(const QRegularExpression& regex, const QString& text) {
+    int result = 0;
+    QRegularExpressionMatchIterator it = regex.globalMatch(text);
+
+    while (it.hasNext()) {
+        if (it.next().capturedLength() > 0) {
+            result++;
+        }
+    }
+
+    return result;
+}
+
+QString Search::snippet(const QString& note, int offset, int length) {
+    int begin = qMax(0, offset - SnippetContext);
+    int end = qMin(note.size(), offset + length + SnippetContext);
+
+    QString result = note.mid(begin, end - begin).simplified();
+
+    if (begin > 0) {
+        result.prepend("...");
+    }
+
+    if (end < note.size()) {
+        result.append("...");
+    }
+
+    return result;
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include "core/Model.h"
+#include <QObject>
+#include <QFutureWatcher>
+#include <QPromise>
+#include <QElapsedTimer>
+
+class QRegularExpression;
+class Database;
+
+class Search : public QObject {
+    Q_OBJECT
+public:
+    enum class Field {
+        All,
+        Title,
+        Note
+    };
+
+    struct Options {
+        QString text;
+        bool regex = false;
+        bool wholeWords = false;
+        bool caseSensitive = false;
+        Field field = Field::All;
+        Id rootId = 0;
+        bool countAll = false;
+    };
+
+    explicit Search(QObject* parent = nullptr);
+    ~Search() override;
+
+    void start(const QString& filePath, const Options& options);
+    void cancel();
+    bool isRunning() const;
+
+    static QRegularExpression regularExpression(const Options& options);
+    static int replace(const Ids& ids, const Options& options, const QString& replacement, Database* database, QVector<Note>& notes);
+
+signals:
+    void found(const QVector<FindNote>& notes);
+    void finished(int count, qint64 elapsed);
+
+private:
+    struct Candidate {
+        Id id = 0;
+        QString title;
+        QVariant note;
+        bool compressed = false;
+        bool matched = false;
+        FindNote findNote;
+    };
+
+    static void exec(QPromise<FindNote>& promise, const QString& filePath, const Options& options);
+    static QString candidatesSql(const Options& options, QVariantMap& params);
+    static bool match(const QRegularExpression& regex, const Options& options, const QString& title, const QString& note, FindNote& findNote);
+    static int count(const QRegularExpression& regex, const QString& text);
+    static QString snippet(const QString& note, int offset, int length);
+
+    QFutureWatcher<FindNote> m_watcher;
+    QElapsedTimer m_timer;
+};
@@ -72,6 +72,30 @@ QString Settings::backupsDirectory() const {
     return value("Backups/directory").toString();
 }
 
+void Settings::setDatabaseCompressNotes(bool compress) {
+    setValue("Database/compressNotes", compress);
+}
+
+bool Settings::databaseCompressNotes() const {
+    return value("Database/compressNotes", true).toBool();
+}
+
+void Settings::setDatabaseHistoryDays(int days) {
+    setValue("Database/historyDays", days);
+}
+
+int Settings::databaseHistoryDays() const {
+    return value("Database/historyDays", 90).toInt();
+}
+
+void Settings::setDatabaseHistoryRevisions(int count) {
+    setValue("Database/historyRevisions", count);
+}
+
+int Settings::databaseHistoryRevisions() const {
+    return value("Database/historyRevisions", 100).toInt();
+}
+
 void Settings::setEditorFontFamily(const QString& fontFamily) {
     setValue("Editor/fontFamily", fontFamily);
 }
@@ -88,6 +112,14 @@ int Settings::editorFontSize() const {
     return value("Editor/fontSize").toInt();
 }
 
+void Settings::setEditorCacheSize(int megabytes) {
+    setValue("Editor/cacheSize", megabytes);
+}
+
+int Settings::editorCacheSize() const {
+    return value("Editor/cacheSize", 64).toInt();
+}
+
 void Settings::setGlobalHotkeyEnabled(bool enabled) {
     setValue("GlobalHotkey/enabled", enabled);
 }
@@ -30,12 +30,24 @@ public:
     void setBackupsDirectory(const QString& directory);
     QString backupsDirectory() const;
 
+    void setDatabaseCompressNotes(bool compress);
+    bool databaseCompressNotes() const;
+
+    void setDatabaseHistoryDays(int days);
+    int databaseHistoryDays() const;
+
+    void setDatabaseHistoryRevisions(int count);
+    int databaseHistoryRevisions() const;
+
     void setEditorFontFamily(const QString& fontFamily);
     QString editorFontFamily() const;
 
     void setEditorFontSize(int fontSize);
     int editorFontSize() const;
 
+    void setEditorCacheSize(int megabytes);
+    int editorCacheSize() const;
+
     void setGlobalHotkeyEnabled(bool enabled);
     bool globalHotkeyEnabled() const;
 
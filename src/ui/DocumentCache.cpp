@@ -0,0 +1,94 @@
+#include "DocumentCache.h"
+#include <QTextDocument>
+
+constexpr auto BlockCost = 256;
+
+DocumentCache::DocumentCache(QObject* parent) : QObject(parent) {
+
+}
+
+DocumentCache::~DocumentCache() {
+    clear();
+}
+
+void DocumentCache::setLimit(qint64 bytes) {
+    m_limit = bytes;
+    evict();
+}
+
+qint64 DocumentCache::limit() const {
+    return m_limit;
+}
+
+qint64 DocumentCache::size() const {
+    return m_size;
+}
+
+int DocumentCache::count() const {
+    return m_entries.count();
+}
+
+void DocumentCache::insert(Id id, const Editor::Snapshot& snapshot) {
+    remove(id);
+
+    Entry entry;
+    entry.snapshot = snapshot;
+    entry.cost = cost(snapshot.document) + snapshot.loadedNote.size() * qint64(sizeof(QChar));
+
+    if (entry.cost > m_limit) {
+        delete snapshot.document;
+        return;
+    }
+
+    snapshot.document->setParent(this);
+
+    m_entries[id] = entry;
+    m_order.prepend(id);
+    m_size += entry.cost;
+
+    evict();
+}
+
+bool DocumentCache::take(Id id, Editor::Snapshot& snapshot) {
+    auto it = m_entries.find(id);
+
+    if (it == m_entries.end()) {
+        return false;
+    }
+
+    snapshot = it->snapshot;
+    m_size -= it->cost;
+    m_entries.erase(it);
+    m_order.removeOne(id);
+
+    return true;
+}
+
+void DocumentCache::remove(Id id) {
+    Editor::Snapshot snapshot;
+
+    if (take(id, snapshot)) {
+        delete snapshot.document;
+    }
+}
+
+void DocumentCache::clear() {
+    for (const Entry& entry : std::as_const(m_entries)) {
+        delete entry.snapshot.document;
+    }
+
+    m_entries.clear();
+    m_order.clear();
+    m_size = 0;
+}
+
+qint64 DocumentCache::cost(const QTextDocument* document) {
+    // Text is stored once in the document, layout and undo data grow with the number of blocks.
+    return document->characterCount() * qint64(sizeof(QChar)) + document->blockCount() * qint64(BlockCost);
+}
+
+void DocumentCache::evict() {
+    while (m_size > m_limit && !m_order.isEmpty()) {
+        remove(m_order.constLast());
+    }
+}
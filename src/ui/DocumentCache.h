@@ -0,0 +1,37 @@
+#pragma once
+#include "Editor.h"
+#include <QObject>
+#include <QHash>
+
+class DocumentCache : public QObject {
+    Q_OBJECT
+public:
+    explicit DocumentCache(QObject* parent = nullptr);
+    ~DocumentCache() override;
+
+    void setLimit(qint64 bytes);
+    qint64 limit() const;
+    qint64 size() const;
+    int count() const;
+
+    void insert(Id id, const Editor::Snapshot& snapshot);
+    bool take(Id id, Editor::Snapshot& snapshot);
+    void remove(Id id);
+    void clear();
+
+    static qint64 cost(const QTextDocument* document);
+
+private:
+    void evict();
+
+    struct Entry {
+        Editor::Snapshot snapshot;
+        qint64 cost = 0;
+    };
+
+    QHash<Id, Entry> m_entries;
+    // Most recently used first.
+    QList<Id> m_order;
+    qint64 m_limit = 0;
+    qint64 m_size = 0;
+};
@@ -1,9 +1,25 @@
 #include "Editor.h"
+#include "MarkdownRenderer.h"
 #include <QMenu>
 #include <QKeyEvent>
+#include <QTimer>
+
+constexpr auto LargeNoteSize = 1024 * 1024;
+constexpr auto LoadChunkSize = 256 * 1024;
+constexpr auto AsyncMarkdownSize = 64 * 1024;
 
 Editor::Editor(QWidget* parent) : QTextEdit(parent) {
     setEnabled(false);
+
+    m_loadTimer = new QTimer(this);
+    m_loadTimer->setSingleShot(true);
+    m_loadTimer->setInterval(0);
+    connect(m_loadTimer, &QTimer::timeout, this, &Editor::loadChunk);
+
+    m_renderer = new MarkdownRenderer(this);
+    connect(m_renderer, &MarkdownRenderer::rendered, this, &Editor::onRendered);
+
+    connect(document(), &QTextDocument::contentsChange, this, &Editor::onContentsChange);
 }
 
 void Editor::setId(Id id) {
@@ -17,15 +33,15 @@ Id Editor::id() const {
 void Editor::setMode(Mode mode) {
     if (mode == m_mode) return;
 
-    m_mode = mode;
+    QString text = note();
 
-    if (mode == Mode::Plain) {
-        setPlainText(toMarkdown());
-    } else if (mode == Mode::Markdown) {
-        setMarkdown(toPlainText());
+    // Edited text is not the stored revision any more, so it is not matched with an earlier rendering.
+    if (m_mode == Mode::Plain && document()->isModified()) {
+        m_revision = --m_localRevision;
     }
 
-    setReadOnly(mode == Mode::Markdown);
+    m_mode = mode;
+    loadNote(text);
 }
 
 Editor::Mode Editor::mode() const {
@@ -33,15 +49,345 @@ Editor::Mode Editor::mode() const {
 }
 
 void Editor::setNote(const QString& note) {
-    if (m_mode == Mode::Plain) {
+    setNote(note, m_mode);
+}
+
+void Editor::setNote(const QString& note, Mode mode) {
+    // Text that does not come from the database gets a revision of its own.
+    setNote(note, mode, --m_localRevision);
+}
+
+void Editor::setNote(const QString& note, Mode mode, Id revision) {
+    // Mode is applied without converting the text of the previous note.
+    m_mode = mode;
+    m_revision = revision;
+    loadNote(note);
+}
+
+void Editor::loadNote(const QString& note) {
+    stopLoading();
+    releaseRendered();
+    m_rendering = false;
+    m_pendingLine = -1;
+    m_markdownSource.clear();
+    setLarge(m_mode == Mode::Plain && note.size() >= LargeNoteSize);
+
+    if (m_large) {
+        // Filling the document at once blocks the UI for seconds, so it is done in chunks between events.
+        m_loadedNote = note;
+        m_loadPosition = 0;
+
+        document()->setUndoRedoEnabled(false);
+        clear();
+        setReadOnly(true);
+        loadChunk();
+    } else if (m_mode == Mode::Plain) {
         setPlainText(note);
+        setReadOnly(false);
     } else if (m_mode == Mode::Markdown) {
-        setMarkdown(note);
+        renderMarkdown(note);
     }
 }
 
 QString Editor::note() const {
-    return m_mode == Mode::Plain ? toPlainText() : toMarkdown();
+    if (m_large) {
+        if (isLoading() || !m_changed) {
+            return m_loadedNote;
+        }
+
+        Change edited = change();
+        return m_loadedNote.left(edited.prefix) + edited.text + m_loadedNote.right(edited.suffix);
+    }
+
+    return m_mode == Mode::Plain ? toPlainText() : m_markdownSource;
+}
+
+Editor::Change Editor::change() const {
+    Change result;
+    result.loadedSize = int(m_loadedNote.size());
+
+    if (!m_large || isLoading() || !m_changed) {
+        result.prefix = result.loadedSize;
+        return result;
+    }
+
+    int length = document()->characterCount() - 1;
+    result.prefix = qMin(m_unchangedPrefix, length);
+    result.suffix = qMin(m_unchangedSuffix, qMin(length, result.loadedSize) - result.prefix);
+
+    QTextCursor cursor(document());
+    cursor.setPosition(result.prefix);
+    cursor.setPosition(length - result.suffix, QTextCursor::KeepAnchor);
+
+    result.text = cursor.selectedText();
+    result.text.replace(QChar::ParagraphSeparator, '\n');
+
+    return result;
+}
+
+void Editor::setSavedNote(const QString& note) {
+    m_revision = --m_localRevision;
+
+    if (!m_large || isLoading()) return;
+
+    // Later edits are tracked against the stored text, so their range stays small.
+    m_loadedNote = note;
+    m_loadPosition = m_loadedNote.size();
+    m_changed = false;
+}
+
+void Editor::setLine(int line) {
+    if (isLoading() || m_rendering) {
+        m_pendingLine = line;
+        return;
+    }
+
+    QTextCursor cursor = textCursor();
+    cursor.movePosition(QTextCursor::Start);
+    cursor.movePosition(QTextCursor::NextBlock, QTextCursor::MoveAnchor, line);
+    setTextCursor(cursor);
+}
+
+int Editor::line() const {
+    return isLoading() || m_rendering ? m_pendingLine : textCursor().blockNumber();
+}
+
+bool Editor::isLarge() const {
+    return m_large;
+}
+
+bool Editor::isLoading() const {
+    return m_large && m_loadPosition < m_loadedNote.size();
+}
+
+bool Editor::isRendering() const {
+    return m_rendering;
+}
+
+void Editor::showMatch(const TextMatch& match, const QString& text) {
+    QTextCursor cursor;
+
+    if (m_mode == Mode::Plain) {
+        // Plain text positions are the offsets in the stored note.
+        int end = document()->characterCount() - 1;
+        cursor = textCursor();
+        cursor.setPosition(qMin(match.offset, end));
+        cursor.setPosition(qMin(match.offset + match.length, end), QTextCursor::KeepAnchor);
+    } else {
+        cursor = document()->find(text);
+    }
+
+    if (!cursor.isNull()) {
+        setTextCursor(cursor);
+        ensureCursorVisible();
+    }
+}
+
+void Editor::loadChunk() {
+    int end = qMin(int(m_loadedNote.size()), m_loadPosition + LoadChunkSize);
+
+    if (end < m_loadedNote.size() && m_loadedNote.at(end - 1).isHighSurrogate()) {
+        end++;
+    }
+
+    QTextCursor cursor(document());
+    cursor.movePosition(QTextCursor::End);
+    cursor.insertText(m_loadedNote.mid(m_loadPosition, end - m_loadPosition));
+    m_loadPosition = end;
+
+    if (isLoading()) {
+        m_loadTimer->start();
+        return;
+    }
+
+    document()->setUndoRedoEnabled(true);
+    document()->setModified(false);
+    setReadOnly(false);
+
+    m_changed = false;
+    m_documentLength = document()->characterCount() - 1;
+
+    if (m_pendingLine >= 0) {
+        setLine(m_pendingLine);
+        m_pendingLine = -1;
+    }
+
+    emit loaded();
+}
+
+void Editor::onRendered(Id id) {
+    if (!m_rendering || id != m_id) return;
+
+    // Render of an older text of the note is dropped, the current one is still running.
+    if (QTextDocument* document = m_renderer->take(id, m_revision)) {
+        showRendered(document);
+    }
+}
+
+void Editor::onContentsChange(int position, int charsRemoved, int charsAdded [[maybe_unused]]) {
+    if (!m_large || isLoading()) return;
+
+    // Text before the first and after the last change is still the loaded one.
+    int suffix = qMax(0, m_documentLength - position - charsRemoved);
+
+    if (m_changed) {
+        m_unchangedPrefix = qMin(m_unchangedPrefix, position);
+        m_unchangedSuffix = qMin(m_unchangedSuffix, suffix);
+    } else {
+        m_unchangedPrefix = position;
+        m_unchangedSuffix = suffix;
+        m_changed = true;
+    }
+
+    m_documentLength = document()->characterCount() - 1;
+}
+
+void Editor::setLarge(bool large) {
+    if (large == m_large) return;
+
+    m_large = large;
+
+    // Wrapping makes every block depend on the widget width and relayout on each resize.
+    setLineWrapMode(large ? QTextEdit::NoWrap : QTextEdit::WidgetWidth);
+
+    if (!large) {
+        m_loadedNote.clear();
+        m_loadPosition = 0;
+        m_changed = false;
+    }
+}
+
+void Editor::renderMarkdown(const QString& markdown) {
+    m_markdownSource = markdown;
+    setReadOnly(true);
+
+    if (QTextDocument* document = m_renderer->take(m_id, m_revision)) {
+        showRendered(document);
+    } else if (markdown.size() < AsyncMarkdownSize) {
+        setMarkdown(markdown);
+        m_rendered = true;
+        m_renderedId = m_id;
+        m_renderedRevision = m_revision;
+    } else {
+        // Source is shown until the worker has parsed and laid out the document.
+        setPlainText(markdown);
+        m_rendering = true;
+        m_renderer->render(m_id, m_revision, markdown, font(), viewport()->width());
+    }
+}
+
+void Editor::showRendered(QTextDocument* document) {
+    delete replaceDocument(document);
+    setReadOnly(true);
+
+    m_rendering = false;
+    m_rendered = true;
+    m_renderedId = m_id;
+    m_renderedRevision = m_revision;
+
+    if (m_pendingLine >= 0) {
+        setLine(m_pendingLine);
+        m_pendingLine = -1;
+    }
+}
+
+void Editor::releaseRendered() {
+    if (!m_rendered) return;
+
+    m_rendered = false;
+    m_renderer->insert(m_renderedId, m_renderedRevision, replaceDocument(new QTextDocument(this)));
+}
+
+void Editor::setCacheLimit(qint64 bytes) {
+    m_renderer->setLimit(bytes);
+}
+
+void Editor::clearCache() {
+    m_renderer->clear();
+    // Shown document is not put back to the cache either, its note belongs to the previous file.
+    m_rendered = false;
+}
+
+QTextDocument* Editor::replaceDocument(QTextDocument* document) {
+    QTextDocument* previous = this->document();
+    disconnect(previous, &QTextDocument::contentsChange, this, &Editor::onContentsChange);
+
+    // Detached first, so that the text control does not delete it with itself as the parent.
+    previous->setParent(nullptr);
+
+    // Extra selections keep cursors of the old document.
+    setExtraSelections({});
+    document->setParent(this);
+    document->setDefaultFont(font());
+    setDocument(document);
+
+    connect(document, &QTextDocument::contentsChange, this, &Editor::onContentsChange);
+    emit documentReplaced();
+
+    return previous;
+}
+
+void Editor::stopLoading() {
+    if (!isLoading()) return;
+
+    m_loadTimer->stop();
+    m_loadPosition = m_loadedNote.size();
+    m_pendingLine = -1;
+
+    document()->setUndoRedoEnabled(true);
+    setReadOnly(m_mode == Mode::Markdown);
+}
+
+Editor::Snapshot Editor::takeDocument() {
+    stopLoading();
+
+    Snapshot result;
+    result.cursor = textCursor();
+    result.mode = m_mode;
+    result.large = m_large;
+    result.loadedNote = m_loadedNote;
+    result.changed = m_changed;
+    result.documentLength = m_documentLength;
+    result.unchangedPrefix = m_unchangedPrefix;
+    result.unchangedSuffix = m_unchangedSuffix;
+    result.markdownSource = m_markdownSource;
+    result.revision = m_revision;
+    result.rendered = m_rendered;
+
+    result.document = replaceDocument(new QTextDocument(this));
+    setLarge(false);
+
+    m_rendering = false;
+    m_rendered = false;
+
+    return result;
+}
+
+void Editor::restoreDocument(const Snapshot& snapshot) {
+    stopLoading();
+    releaseRendered();
+    delete replaceDocument(snapshot.document);
+
+    m_mode = snapshot.mode;
+    setReadOnly(m_mode == Mode::Markdown);
+    setLarge(snapshot.large);
+
+    m_loadedNote = snapshot.loadedNote;
+    m_loadPosition = m_loadedNote.size();
+    m_changed = snapshot.changed;
+    m_documentLength = snapshot.documentLength;
+    m_unchangedPrefix = snapshot.unchangedPrefix;
+    m_unchangedSuffix = snapshot.unchangedSuffix;
+
+    m_markdownSource = snapshot.markdownSource;
+    m_revision = snapshot.revision;
+    m_rendering = false;
+    m_rendered = snapshot.rendered;
+    m_renderedId = m_id;
+    m_renderedRevision = m_revision;
+
+    setTextCursor(snapshot.cursor);
+    ensureCursorVisible();
 }
 
 void Editor::focusOutEvent(QFocusEvent* event) {
@@ -1,7 +1,10 @@
 #pragma once
-#include "core/Globals.h"
+#include "core/Model.h"
 #include <QTextEdit>
 
+class QTimer;
+class MarkdownRenderer;
+
 class Editor : public QTextEdit {
     Q_OBJECT
 public:
@@ -10,6 +13,30 @@ public:
         Markdown
     };
 
+    // Document of a note with the cursor and the editor state, kept while another note is open.
+    struct Snapshot {
+        QTextDocument* document = nullptr;
+        QTextCursor cursor;
+        Mode mode = Mode::Plain;
+        bool large = false;
+        QString loadedNote;
+        bool changed = false;
+        int documentLength = 0;
+        int unchangedPrefix = 0;
+        int unchangedSuffix = 0;
+        QString markdownSource;
+        Id revision = 0;
+        bool rendered = false;
+    };
+
+    // Edited range of a large note, the text around it is still the loaded one.
+    struct Change {
+        int loadedSize = 0;
+        int prefix = 0;
+        int suffix = 0;
+        QString text;
+    };
+
     explicit Editor(QWidget* parent = nullptr);
 
     void setId(Id id);
@@ -19,18 +46,76 @@ public:
     Mode mode() const;
 
     void setNote(const QString& note);
+    void setNote(const QString& note, Mode mode);
+    // Revision identifies the stored text, rendered Markdown of the note is reused while it is the same.
+    void setNote(const QString& note, Mode mode, Id revision);
     QString note() const;
+    Change change() const;
+    void setSavedNote(const QString& note);
+
+    void setLine(int line);
+    int line() const;
+
+    bool isLarge() const;
+    bool isLoading() const;
+    bool isRendering() const;
+
+    void showMatch(const TextMatch& match, const QString& text);
+
+    void setCacheLimit(qint64 bytes);
+    void clearCache();
+
+    Snapshot takeDocument();
+    void restoreDocument(const Snapshot& snapshot);
 
 signals:
     void focusLost();
     void leave();
+    void loaded();
+    void documentReplaced();
 
 protected:
     void focusOutEvent(QFocusEvent* event) override;
     void keyPressEvent(QKeyEvent* event) override;
     void contextMenuEvent(QContextMenuEvent* event) override;
 
+private slots:
+    void loadChunk();
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+    void onRendered(Id id);
+
 private:
+    void loadNote(const QString& note);
+    void setLarge(bool large);
+    void stopLoading();
+    void renderMarkdown(const QString& markdown);
+    void showRendered(QTextDocument* document);
+    void releaseRendered();
+    QTextDocument* replaceDocument(QTextDocument* document);
+
     Id m_id = 0;
     Mode m_mode = Mode::Plain;
+
+    // Large plain notes are loaded in chunks and saved by splicing the edited range into the loaded text.
+    bool m_large = false;
+    QTimer* m_loadTimer = nullptr;
+    QString m_loadedNote;
+    int m_loadPosition = 0;
+    int m_pendingLine = -1;
+
+    bool m_changed = false;
+    int m_documentLength = 0;
+    int m_unchangedPrefix = 0;
+    int m_unchangedSuffix = 0;
+
+    // Markdown notes are read-only, their source is kept instead of converting the document back.
+    MarkdownRenderer* m_renderer = nullptr;
+    QString m_markdownSource;
+    Id m_revision = 0;
+    // Text set without a stored revision is numbered downwards, so it never matches a database one.
+    Id m_localRevision = 0;
+    bool m_rendering = false;
+    bool m_rendered = false;
+    Id m_renderedId = 0;
+    Id m_renderedRevision = 0;
 };
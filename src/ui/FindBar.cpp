@@ -0,0 +1,273 @@
+#include "FindBar.h"
+#include "Editor.h"
+#include <QtConcurrent>
+#include <QLineEdit>
+#include <QLabel>
+#include <QToolButton>
+#include <QHBoxLayout>
+#include <QScrollBar>
+#include <QKeyEvent>
+#include <QTimer>
+
+constexpr auto FindInterval = 150;
+constexpr auto CancelCheckInterval = 4096;
+constexpr QRgb MatchColor = 0xfff0a0;
+constexpr QRgb CurrentMatchColor = 0xffb040;
+
+FindBar::FindBar(Editor* editor, QWidget* parent) : QWidget(parent), m_editor(editor) {
+    m_lineEdit = new QLineEdit;
+    m_lineEdit->setPlaceholderText(tr("Find"));
+    m_lineEdit->installEventFilter(this);
+
+    m_countLabel = new QLabel;
+
+    m_caseButton = new QToolButton;
+    m_caseButton->setText("Aa");
+    m_caseButton->setToolTip(tr("Case sensitive"));
+    m_caseButton->setCheckable(true);
+
+    auto previousButton = new QToolButton;
+    previousButton->setArrowType(Qt::UpArrow);
+    previousButton->setToolTip(tr("Find Previous"));
+    connect(previousButton, &QToolButton::clicked, this, &FindBar::findPrevious);
+
+    auto nextButton = new QToolButton;
+    nextButton->setArrowType(Qt::DownArrow);
+    nextButton->setToolTip(tr("Find Next"));
+    connect(nextButton, &QToolButton::clicked, this, &FindBar::findNext);
+
+    auto closeButton = new QToolButton;
+    closeButton->setText("×");
+    closeButton->setToolTip(tr("Close"));
+    connect(closeButton, &QToolButton::clicked, this, &FindBar::deactivate);
+
+    auto horizontalLayout = new QHBoxLayout;
+    horizontalLayout->setContentsMargins(2, 2, 2, 2);
+    horizontalLayout->addWidget(m_lineEdit, 1);
+    horizontalLayout->addWidget(m_countLabel);
+    horizontalLayout->addWidget(m_caseButton);
+    horizontalLayout->addWidget(previousButton);
+    horizontalLayout->addWidget(nextButton);
+    horizontalLayout->addWidget(closeButton);
+    setLayout(horizontalLayout);
+
+    m_timer = new QTimer(this);
+    m_timer->setSingleShot(true);
+    m_timer->setInterval(FindInterval);
+    connect(m_timer, &QTimer::timeout, this, &FindBar::find);
+
+    connect(m_lineEdit, &QLineEdit::textChanged, this, [this] {
+        m_jump = true;
+        m_timer->start();
+    });
+
+    connect(m_caseButton, &QToolButton::toggled, this, [this] {
+        m_jump = true;
+        find();
+    });
+
+    // Edits shift the positions, so the search is repeated once typing pauses.
+    connect(m_editor, &QTextEdit::textChanged, this, [this] {
+        if (isVisible()) {
+            m_timer->start();
+        }
+    });
+
+    connect(m_editor, &Editor::documentReplaced, this, [this] {
+        if (isVisible()) {
+            m_timer->start();
+        }
+    });
+
+    connect(&m_watcher, &QFutureWatcher<QVector<int>>::finished, this, &FindBar::onFound);
+    connect(m_editor->verticalScrollBar(), &QScrollBar::valueChanged, this, &FindBar::updateSelections);
+    m_editor->viewport()->installEventFilter(this);
+
+    setVisible(false);
+}
+
+void FindBar::activate() {
+    QTextCursor cursor = m_editor->textCursor();
+
+    if (cursor.hasSelection() && !cursor.selectedText().contains(QChar::ParagraphSeparator)) {
+        m_lineEdit->setText(cursor.selectedText());
+    }
+
+    setVisible(true);
+    m_lineEdit->setFocus();
+    m_lineEdit->selectAll();
+
+    m_jump = true;
+    find();
+}
+
+int FindBar::matchCount() const {
+    return m_positions.count();
+}
+
+void FindBar::findNext() {
+    if (m_positions.isEmpty()) return;
+    setCurrent((m_current + 1) % m_positions.count());
+}
+
+void FindBar::findPrevious() {
+    if (m_positions.isEmpty()) return;
+    setCurrent((m_current - 1 + m_positions.count()) % m_positions.count());
+}
+
+void FindBar::deactivate() {
+    m_timer->stop();
+    m_watcher.cancel();
+    setVisible(false);
+
+    m_positions.clear();
+    m_current = -1;
+    updateSelections();
+    emit matchesChanged(0);
+
+    m_editor->setFocus();
+}
+
+bool FindBar::eventFilter(QObject* watched, QEvent* event) {
+    if (watched == m_editor->viewport()) {
+        if (event->type() == QEvent::Resize) {
+            updateSelections();
+        }
+
+        return false;
+    }
+
+    // Escape is a window shortcut, take it over while the find field has focus.
+    if (event->type() == QEvent::ShortcutOverride && static_cast<QKeyEvent*>(event)->key() == Qt::Key_Escape) {
+        event->accept();
+        return true;
+    }
+
+    if (event->type() == QEvent::KeyPress) {
+        auto keyEvent = static_cast<QKeyEvent*>(event);
+
+        if (keyEvent->key() == Qt::Key_Escape) {
+            deactivate();
+            return true;
+        }
+
+        if (keyEvent->key() == Qt::Key_Return || keyEvent->key() == Qt::Key_Enter) {
+            if (keyEvent->modifiers() & Qt::ShiftModifier) {
+                findPrevious();
+            } else {
+                findNext();
+            }
+
+            return true;
+        }
+    }
+
+    return QWidget::eventFilter(watched, event);
+}
+
+void FindBar::find() {
+    m_timer->stop();
+    m_watcher.cancel();
+
+    QString pattern = m_lineEdit->text();
+
+    if (pattern.isEmpty() || !isVisible()) {
+        m_positions.clear();
+        m_current = -1;
+        updateCountLabel();
+        updateSelections();
+        emit matchesChanged(0);
+        return;
+    }
+
+    m_pendingLength = pattern.size();
+    Qt::CaseSensitivity cs = m_caseButton->isChecked() ? Qt::CaseSensitive : Qt::CaseInsensitive;
+
+    // Plain text of the document has the same positions as the document itself.
+    m_watcher.setFuture(QtConcurrent::run(&FindBar::findAll, m_editor->toPlainText(), pattern, cs));
+}
+
+void FindBar::onFound() {
+    if (m_watcher.isCanceled() || !m_watcher.future().resultCount()) return;
+
+    m_positions = m_watcher.result();
+    m_length = m_pendingLength;
+
+    // Current match is the first one from the cursor, the cursor only moves on a new search.
+    int position = m_editor->textCursor().selectionStart();
+    auto it = std::lower_bound(m_positions.cbegin(), m_positions.cend(), position);
+    m_current = m_positions.isEmpty() ? -1 : int(it - m_positions.cbegin()) % m_positions.count();
+
+    if (m_jump && m_current >= 0) {
+        setCurrent(m_current);
+    } else {
+        updateCountLabel();
+        updateSelections();
+    }
+
+    m_jump = false;
+    emit matchesChanged(m_positions.count());
+}
+
+void FindBar::updateSelections() {
+    QList<QTextEdit::ExtraSelection> selections;
+
+    if (isVisible() && !m_positions.isEmpty()) {
+        // Only matches in the viewport are highlighted, a huge note may have thousands of them.
+        QWidget* viewport = m_editor->viewport();
+        int first = m_editor->cursorForPosition(QPoint(0, 0)).position();
+        int last = m_editor->cursorForPosition(QPoint(viewport->width(), viewport->height())).position();
+
+        auto it = std::lower_bound(m_positions.cbegin(), m_positions.cend(), first - m_length);
+
+        for (; it != m_positions.cend() && *it <= last; it++) {
+            QTextEdit::ExtraSelection selection;
+            selection.cursor = QTextCursor(m_editor->document());
+            selection.cursor.setPosition(*it);
+            selection.cursor.setPosition(*it + m_length, QTextCursor::KeepAnchor);
+
+            bool current = it - m_positions.cbegin() == m_current;
+            selection.format.setBackground(QColor(current ? CurrentMatchColor : MatchColor));
+            selections.append(selection);
+        }
+    }
+
+    m_editor->setExtraSelections(selections);
+}
+
+void FindBar::findAll(QPromise<QVector<int>>& promise, const QString& text, const QString& pattern, Qt::CaseSensitivity cs) {
+    QVector<int> result;
+
+    for (qsizetype i = text.indexOf(pattern, 0, cs); i >= 0; i = text.indexOf(pattern, i + pattern.size(), cs)) {
+        result.append(i);
+
+        if (result.count() % CancelCheckInterval == 0 && promise.isCanceled()) {
+            return;
+        }
+    }
+
+    promise.addResult(result);
+}
+
+void FindBar::setCurrent(int index) {
+    m_current = index;
+
+    QTextCursor cursor = m_editor->textCursor();
+    cursor.setPosition(m_positions.at(index));
+    cursor.setPosition(m_positions.at(index) + m_length, QTextCursor::KeepAnchor);
+    m_editor->setTextCursor(cursor);
+    m_editor->ensureCursorVisible();
+
+    updateCountLabel();
+    updateSelections();
+}
+
+void FindBar::updateCountLabel() {
+    if (m_lineEdit->text().isEmpty()) {
+        m_countLabel->clear();
+    } else if (m_positions.isEmpty()) {
+        m_countLabel->setText(tr("No results"));
+    } else {
+        m_countLabel->setText(tr("%1 of %2").arg(m_current + 1).arg(m_positions.count()));
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <QWidget>
+#include <QFutureWatcher>
+#include <QPromise>
+
+class QLineEdit;
+class QLabel;
+class QToolButton;
+class QTimer;
+
+class Editor;
+
+class FindBar : public QWidget {
+    Q_OBJECT
+public:
+    explicit FindBar(Editor* editor, QWidget* parent = nullptr);
+
+    void activate();
+    int matchCount() const;
+
+public slots:
+    void findNext();
+    void findPrevious();
+    void deactivate();
+
+signals:
+    void matchesChanged(int count);
+
+protected:
+    bool eventFilter(QObject* watched, QEvent* event) override;
+
+private slots:
+    void find();
+    void onFound();
+    void updateSelections();
+
+private:
+    static void findAll(QPromise<QVector<int>>& promise, const QString& text, const QString& pattern, Qt::CaseSensitivity cs);
+
+    void setCurrent(int index);
+    void updateCountLabel();
+
+    Editor* m_editor = nullptr;
+    QLineEdit* m_lineEdit = nullptr;
+    QLabel* m_countLabel = nullptr;
+    QToolButton* m_caseButton = nullptr;
+    QTimer* m_timer = nullptr;
+
+    QFutureWatcher<QVector<int>> m_watcher;
+
+    // Match positions in the document, found once per text change.
+    QVector<int> m_positions;
+    int m_length = 0;
+    int m_pendingLength = 0;
+    int m_current = -1;
+    bool m_jump = false;
+};
@@ -1,29 +1,45 @@
 #include "MainWindow.h"
 #include "RecentFilesMenu.h"
 #include "Editor.h"
+#include "FindBar.h"
+#include "DocumentCache.h"
 #include "TrayIcon.h"
 #include "Birthdays.h"
 #include "core/Application.h"
 #include "core/Exception.h"
 #include "core/SolidString.h"
 #include "core/Exporter.h"
+#include "core/Importer.h"
 #include "settings/FileSettings.h"
 #include "dialog/Preferences.h"
 #include "dialog/FindAllNotesDialog.h"
+#include "dialog/ExportDialog.h"
+#include "dialog/DiagnosticsDialog.h"
+#include "dialog/HistoryDialog.h"
 #include "notetaking/NoteTaking.h"
+#include "notetaking/NoteFilter.h"
 #include "database/Database.h"
+#include "database/Maintenance.h"
+#include "database/RecoveryJournal.h"
+#include "database/Search.h"
 #include "hotkey/GlobalHotkey.h"
 #include "server/HttpServerManager.h"
 #include <QSplitter>
+#include <QLineEdit>
+#include <QVBoxLayout>
 #include <QMenuBar>
 #include <QMessageBox>
 #include <QFileDialog>
-#include <QInputDialog>
 #include <QScreen>
 #include <QDesktopServices>
 #include <QFile>
 #include <QFileInfo>
 #include <QCloseEvent>
+#include <QTimer>
+
+constexpr auto IdleInterval = 5 * 60 * 1000;
+constexpr auto MaintenanceInterval = 24 * 60 * 60;
+constexpr auto JournalInterval = 2000;
 
 MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent) {
     setWindowTitle(Application::Name);
@@ -36,6 +52,21 @@ MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent) {
 
     m_database = new Database(this);
     m_serverManager = new HttpServerManager(m_database, this);
+    m_maintenance = new Maintenance(this);
+    m_documentCache = new DocumentCache(this);
+
+    m_idleTimer = new QTimer(this);
+    m_idleTimer->setSingleShot(true);
+    m_idleTimer->setInterval(IdleInterval);
+    connect(m_idleTimer, &QTimer::timeout, this, &MainWindow::onIdle);
+
+    m_journal = new RecoveryJournal(this);
+
+    // Not restarted by typing, so a long edit is still written every interval.
+    m_journalTimer = new QTimer(this);
+    m_journalTimer->setSingleShot(true);
+    m_journalTimer->setInterval(JournalInterval);
+    connect(m_journalTimer, &QTimer::timeout, this, &MainWindow::writeJournal);
 
     m_globalHotkey = new GlobalHotkey(this);
     connect(m_globalHotkey, &GlobalHotkey::activated, this, &MainWindow::onGlobalActivated);
@@ -51,6 +82,14 @@ MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent) {
        m_notetaking->setFocus();
     });
 
+    connect(m_notetaking, &NoteTaking::noteChanged, m_idleTimer, qOverload<>(&QTimer::start));
+    connect(m_editor, &Editor::textChanged, m_idleTimer, qOverload<>(&QTimer::start));
+    connect(m_editor, &Editor::textChanged, this, [this] {
+        if (!m_journalTimer->isActive()) {
+            m_journalTimer->start();
+        }
+    });
+
     setCurrentFile("");
     readSettings();
 }
@@ -60,6 +99,9 @@ MainWindow::~MainWindow() {
 }
 
 void MainWindow::quit() {
+    // Selection is saved after a pause and the editor on focus loss, neither happens on exit.
+    m_notetaking->saveSelectedId();
+    saveEditor();
     writeSettings();
     QCoreApplication::quit();
 }
@@ -123,6 +165,17 @@ void MainWindow::applyHotSettings() {
         m_editor->setFont(font);
     }
 
+    m_database->setCompressNotes(m_fileSettings->databaseCompressNotes());
+
+    Maintenance::Options maintenanceOptions;
+    maintenanceOptions.compressNotes = m_fileSettings->databaseCompressNotes();
+    maintenanceOptions.historyDays = m_fileSettings->databaseHistoryDays();
+    maintenanceOptions.historyRevisions = m_fileSettings->databaseHistoryRevisions();
+    m_maintenance->setOptions(maintenanceOptions);
+
+    m_documentCache->setLimit(qint64(m_fileSettings->editorCacheSize()) * 1024 * 1024);
+    m_editor->setCacheLimit(qint64(m_fileSettings->editorCacheSize()) * 1024 * 1024);
+
     m_serverManager->stop();
 
     if (!m_fileSettings->serverEnabled()) {
@@ -163,8 +216,55 @@ void MainWindow::setupSplitter() {
     m_notetaking = new NoteTaking(m_database);
     m_editor = new Editor;
 
-    m_splitter->addWidget(m_notetaking);
-    m_splitter->addWidget(m_editor);
+    m_filterLineEdit = new QLineEdit;
+    m_filterLineEdit->setPlaceholderText(tr("Filter"));
+    m_filterLineEdit->setClearButtonEnabled(true);
+    m_filterLineEdit->setEnabled(false);
+    connect(m_filterLineEdit, &QLineEdit::textChanged, this, &MainWindow::onFilterChanged);
+    connect(m_filterLineEdit, &QLineEdit::returnPressed, this, [this] {
+        m_noteFilter->setFocus();
+    });
+    connect(this, &MainWindow::isOpened, m_filterLineEdit, &QLineEdit::setEnabled);
+
+    m_noteFilter = new NoteFilter(m_database);
+    m_noteFilter->setVisible(false);
+    connect(m_noteFilter, &NoteFilter::noteActivated, m_notetaking, &NoteTaking::setCurrentId);
+
+    connect(m_notetaking, &NoteTaking::treeReset, m_noteFilter, &NoteFilter::invalidate);
+    connect(m_notetaking, &NoteTaking::noteInserted, m_noteFilter, &NoteFilter::addNote);
+    connect(m_notetaking, &NoteTaking::noteRenamed, m_noteFilter, &NoteFilter::renameNote);
+    connect(m_notetaking, &NoteTaking::noteMoved, m_noteFilter, &NoteFilter::moveNote);
+    connect(m_notetaking, &NoteTaking::notesRemoved, m_noteFilter, &NoteFilter::removeNotes);
+    connect(m_notetaking, &NoteTaking::notesRemoved, this, [this] (const Ids& ids) {
+        for (Id id : ids) {
+            m_documentCache->remove(id);
+        }
+    });
+
+    auto notesLayout = new QVBoxLayout;
+    notesLayout->setContentsMargins(0, 0, 0, 0);
+    notesLayout->setSpacing(0);
+    notesLayout->addWidget(m_filterLineEdit);
+    notesLayout->addWidget(m_notetaking);
+    notesLayout->addWidget(m_noteFilter);
+
+    auto notesWidget = new QWidget;
+    notesWidget->setLayout(notesLayout);
+
+    m_splitter->addWidget(notesWidget);
+
+    m_findBar = new FindBar(m_editor);
+
+    auto editorLayout = new QVBoxLayout;
+    editorLayout->setContentsMargins(0, 0, 0, 0);
+    editorLayout->setSpacing(0);
+    editorLayout->addWidget(m_editor);
+    editorLayout->addWidget(m_findBar);
+
+    auto editorWidget = new QWidget;
+    editorWidget->setLayout(editorLayout);
+
+    m_splitter->addWidget(editorWidget);
 
     m_splitter->setHandleWidth(1);
     m_splitter->setChildrenCollapsible(false);
@@ -180,16 +280,25 @@ void MainWindow::createActions() {
     connect(m_recentFilesMenu, &RecentFilesMenu::activated, this, &MainWindow::loadFile);
     fileMenu->addAction(m_recentFilesMenu->menuAction());
 
-    auto exportAction = fileMenu->addAction(tr("Export All..."), Qt::CTRL | Qt::Key_E, this, &MainWindow::exportAll);
+    auto exportAction = fileMenu->addAction(tr("Export..."), Qt::CTRL | Qt::Key_E, this, &MainWindow::exportNotes);
+    auto importDirectoryAction = fileMenu->addAction(tr("Import from Directory..."), this, &MainWindow::importDirectory);
+    auto importArchiveAction = fileMenu->addAction(tr("Import from ZIP Archive..."), this, &MainWindow::importArchive);
     auto createBackupAction = fileMenu->addAction(tr("Create Backup..."), this, &MainWindow::backup);
+    auto diagnosticsAction = fileMenu->addAction(tr("Database Diagnostics..."), this, &MainWindow::showDiagnostics);
     auto closeAction = fileMenu->addAction(tr("Close"), Qt::CTRL | Qt::Key_W, this, &MainWindow::closeFile);
 
     exportAction->setEnabled(false);
+    importDirectoryAction->setEnabled(false);
+    importArchiveAction->setEnabled(false);
     createBackupAction->setEnabled(false);
+    diagnosticsAction->setEnabled(false);
     closeAction->setEnabled(false);
 
     connect(this, &MainWindow::isOpened, exportAction, &QAction::setEnabled);
+    connect(this, &MainWindow::isOpened, importDirectoryAction, &QAction::setEnabled);
+    connect(this, &MainWindow::isOpened, importArchiveAction, &QAction::setEnabled);
     connect(this, &MainWindow::isOpened, createBackupAction, &QAction::setEnabled);
+    connect(this, &MainWindow::isOpened, diagnosticsAction, &QAction::setEnabled);
     connect(this, &MainWindow::isOpened, closeAction, &QAction::setEnabled);
 
     fileMenu->addSeparator();
@@ -211,8 +320,11 @@ void MainWindow::createActions() {
     m_editMenu->addSeparator();
     auto findAction = m_editMenu->addAction(tr("Find..."), QKeySequence::Find, this, &MainWindow::find);
     auto findAllAction = m_editMenu->addAction(tr("Find in All Notes..."), QKeySequence(Qt::CTRL | Qt::SHIFT | Qt::Key_F), this, &MainWindow::findInAllNotes);
+    auto replaceAllAction = m_editMenu->addAction(tr("Replace in All Notes..."), QKeySequence(Qt::CTRL | Qt::SHIFT | Qt::Key_H), this, &MainWindow::replaceInAllNotes);
     m_findNextAction = m_editMenu->addAction(tr("Find Next"), QKeySequence::FindNext, this, &MainWindow::findNext);
     m_findPreviousAction = m_editMenu->addAction(tr("Find Previous"), QKeySequence::FindPrevious, this, &MainWindow::findPrevious);
+    m_editMenu->addSeparator();
+    auto historyAction = m_editMenu->addAction(tr("History..."), this, &MainWindow::showHistory);
 
     undoAction->setEnabled(false);
     redoAction->setEnabled(false);
@@ -221,8 +333,10 @@ void MainWindow::createActions() {
     selectAllAction->setEnabled(false);
     findAction->setEnabled(false);
     findAllAction->setEnabled(false);
+    replaceAllAction->setEnabled(false);
     m_findNextAction->setEnabled(false);
     m_findPreviousAction->setEnabled(false);
+    historyAction->setEnabled(false);
 
     connect(m_editor, &QTextEdit::undoAvailable, undoAction, &QAction::setEnabled);
     connect(m_editor, &QTextEdit::redoAvailable, redoAction, &QAction::setEnabled);
@@ -234,6 +348,12 @@ void MainWindow::createActions() {
     connect(this, &MainWindow::isOpened, pasteAction, &QAction::setEnabled);
     connect(this, &MainWindow::isOpened, findAction, &QAction::setEnabled);
     connect(this, &MainWindow::isOpened, findAllAction, &QAction::setEnabled);
+    connect(m_findBar, &FindBar::matchesChanged, this, [this] (int count) {
+        m_findNextAction->setEnabled(count > 0);
+        m_findPreviousAction->setEnabled(count > 0);
+    });
+    connect(this, &MainWindow::isOpened, replaceAllAction, &QAction::setEnabled);
+    connect(this, &MainWindow::isOpened, historyAction, &QAction::setEnabled);
 
     m_eventsMenu = menuBar()->addMenu(tr("Events"));
     m_eventsMenu->addAction(tr("Birthdays..."), this, &MainWindow::showBirthdays);
@@ -248,8 +368,16 @@ void MainWindow::createActions() {
 void MainWindow::loadFile(const QString& filePath) {
     if (filePath.isEmpty() || !QFile::exists(filePath)) return;
 
+    // Pending selection and edits belong to the previous file, its documents must not be cached under the new ids.
+    m_notetaking->saveSelectedId();
+    saveEditor();
+    m_editor->setId(0);
+    m_documentCache->clear();
+    m_editor->clearCache();
+
     try {
         m_database->open(filePath);
+        recoverNotes(filePath);
         m_notetaking->build();
         setCurrentFile(filePath);
         m_recentFilesMenu->addPath(filePath);
@@ -257,11 +385,43 @@ void MainWindow::loadFile(const QString& filePath) {
         if (m_database->isBirthdayToday()) {
             showBirthdays();
         }
+
+        m_idleTimer->start();
     } catch (const Exception& e) {
         showErrorDialog(e.error());
     }
 }
 
+void MainWindow::recoverNotes(const QString& filePath) {
+    QVector<RecoveryJournal::Entry> entries = RecoveryJournal::read(filePath);
+
+    if (!entries.isEmpty()) {
+        auto answer = QMessageBox::question(this, Application::Name,
+            tr("Unsaved changes of %n note(s) were found after the last session. Restore them?", nullptr, entries.count()));
+
+        if (answer == QMessageBox::Yes) {
+            for (const auto& entry : std::as_const(entries)) {
+                // Note could be removed after its text was written to the journal.
+                if (!m_database->noteValue(entry.id, "id").isValid()) continue;
+
+                if (entry.change.isEmpty()) {
+                    m_database->updateNoteValue(entry.id, "note", entry.note);
+                    continue;
+                }
+
+                // Change applies only to the text it was taken against.
+                QString note = m_database->noteValue(entry.id, "note").toString();
+
+                if (note.size() == entry.baseSize) {
+                    m_database->updateNoteValue(entry.id, "note", Database::applyDelta(note, entry.change));
+                }
+            }
+        }
+    }
+
+    m_journal->open(filePath);
+}
+
 void MainWindow::setCurrentFile(const QString& filePath) {
     QString title = QApplication::applicationName();
     bool isFileOpened = !filePath.isEmpty();
@@ -278,6 +438,14 @@ void MainWindow::setCurrentFile(const QString& filePath) {
     emit isOpened(isFileOpened);
 }
 
+void MainWindow::importNotes(const QString& path) {
+    try {
+        Importer::importAll(path, m_notetaking, m_database, this);
+    } catch (const Exception& e) {
+        showErrorDialog(e.error());
+    }
+}
+
 void MainWindow::showErrorDialog(const QString& message) {
     QMessageBox::critical(this, Application::Name, message, QMessageBox::Ok);
 }
@@ -289,6 +457,8 @@ QString MainWindow::dateFileName(const QString& name) {
 }
 
 void MainWindow::closeEvent(QCloseEvent* event) {
+    m_notetaking->saveSelectedId();
+    saveEditor();
     writeSettings();
     event->accept();
 }
@@ -324,13 +494,49 @@ void MainWindow::open() {
     }
 }
 
-void MainWindow::exportAll() {
-    QFileInfo fi(m_currentFile);
-    QString name = m_fileSettings->backupsDirectory() + "/" + dateFileName(fi.baseName() + ".zip");
-    QString filePath = QFileDialog::getSaveFileName(this, tr("Export notes to ZIP archive"), name);
+void MainWindow::exportNotes() {
+    Ids selectedIds = m_notetaking->selectedIds();
+    ExportDialog exportDialog(selectedIds.count(), this);
+
+    if (exportDialog.exec() != QDialog::Accepted) return;
+
+    Ids rootIds = exportDialog.selectedOnly() ? selectedIds : Ids();
+
+    try {
+        if (exportDialog.syncToFolder()) {
+            QString dirPath = QFileDialog::getExistingDirectory(this, tr("Sync notes to folder"), m_fileSettings->backupsDirectory());
+
+            if (!dirPath.isEmpty()) {
+                Exporter::syncToFolder(dirPath, rootIds, exportDialog.format(), m_database, this);
+            }
+        } else {
+            QFileInfo fi(m_currentFile);
+            QString name = m_fileSettings->backupsDirectory() + "/" + dateFileName(fi.baseName() + ".zip");
+            QString filePath = QFileDialog::getSaveFileName(this, tr("Export notes to ZIP archive"), name);
+
+            if (!filePath.isEmpty()) {
+                Exporter::exportAll(filePath, rootIds, exportDialog.format(), m_database, this);
+            }
+        }
+    } catch (const Exception& e) {
+        showErrorDialog(e.error());
+    }
+}
+
+void MainWindow::importDirectory() {
+    QString dirPath = QFileDialog::getExistingDirectory(this, tr("Import notes from directory"), m_fileSettings->backupsDirectory());
+
+    if (!dirPath.isEmpty()) {
+        importNotes(dirPath);
+    }
+}
+
+void MainWindow::importArchive() {
+    QString filePath = QFileDialog::getOpenFileName(this, tr("Import notes from ZIP archive"), m_fileSettings->backupsDirectory(),
+                                                    tr("ZIP Archives (*.zip);;All Files (*)"));
 
     if (!filePath.isEmpty()) {
-        Exporter::exportAll(filePath, m_notetaking, m_database, this);
+        importNotes(filePath);
     }
 }
 
@@ -346,8 +552,15 @@ void MainWindow::backup() {
 }
 
 void MainWindow::closeFile() {
+    m_idleTimer->stop();
+    m_notetaking->saveSelectedId();
+    saveEditor();
+    m_journal->close();
     m_database->close();
     onNoteChanged(0);
+    m_documentCache->clear();
+    m_editor->clearCache();
+    m_filterLineEdit->clear();
     m_notetaking->clear();
     setCurrentFile();
 }
@@ -361,43 +574,79 @@ void MainWindow::showPreferences() {
 }
 
 void MainWindow::find() {
-    bool ok;
-    m_findText = QInputDialog::getText(this, tr("Find"), tr("Text:"), QLineEdit::Normal, "", &ok);
-
-    if (!ok || m_findText.isEmpty()) {
-        return;
-    }
-
-    QTextCursor cursor = m_editor->textCursor();
-    QTextCursor savedCursor = cursor;
-
-    cursor.movePosition(QTextCursor::Start);\
-    m_editor->setTextCursor(cursor);
-
-    if (!m_editor->find(m_findText)) {
-        QMessageBox::warning(this, Application::Name, tr("Text not found"));
-        m_editor->setTextCursor(savedCursor);
-        return;
-    }
-
-    m_findNextAction->setEnabled(true);
-    m_findPreviousAction->setEnabled(true);
+    m_findBar->activate();
 }
 
 void MainWindow::findInAllNotes() {
-    FindAllNotesDialog findAllNotesDialog(m_database);
+    FindAllNotesDialog findAllNotesDialog(m_database, m_notetaking->currentId());
 
     if (findAllNotesDialog.exec() == QDialog::Accepted) {
-        m_notetaking->setCurrentId(findAllNotesDialog.noteId());
+        FindNote findNote = findAllNotesDialog.findNote();
+        m_notetaking->setCurrentId(findNote.id);
+
+        if (!findNote.matches.isEmpty()) {
+            m_editor->showMatch(findNote.matches.constFirst(), findNote.matchText);
+        }
     }
 }
 
 void MainWindow::findNext() {
-    m_editor->find(m_findText);
+    m_findBar->findNext();
 }
 
 void MainWindow::findPrevious() {
-    m_editor->find(m_findText, QTextDocument::FindBackward);
+    m_findBar->findPrevious();
+}
+
+void MainWindow::replaceInAllNotes() {
+    // Replacement works with the stored text, so unsaved changes go first.
+    onEditorFocusLost();
+
+    FindAllNotesDialog replaceDialog(m_database, m_notetaking->currentId(), FindAllNotesDialog::Mode::Replace);
+
+    if (replaceDialog.exec() != QDialog::Accepted) return;
+
+    try {
+        QVector<Note> notes;
+        int count = Search::replace(replaceDialog.noteIds(), replaceDialog.options(), replaceDialog.replacement(), m_database, notes);
+
+        m_notetaking->updateTitles(notes);
+
+        for (const Note& note : notes) {
+            m_documentCache->remove(note.id);
+        }
+
+        Id editorId = m_editor->id();
+
+        if (std::any_of(notes.cbegin(), notes.cend(), [=] (const Note& note) { return note.id == editorId; })) {
+            onNoteChanged(editorId);
+        }
+
+        QMessageBox::information(this, Application::Name, tr("Replaced: %1 in %2 notes").arg(count).arg(notes.count()));
+    } catch (const Exception& e) {
+        showErrorDialog(e.error());
+    }
+}
+
+void MainWindow::showHistory() {
+    Id id = m_editor->id();
+
+    if (!id) return;
+
+    // Unsaved changes become the latest revision.
+    onEditorFocusLost();
+
+    HistoryDialog historyDialog(m_database, id, this);
+
+    if (historyDialog.exec() != QDialog::Accepted) return;
+
+    try {
+        m_database->updateNoteValue(id, "note", historyDialog.text());
+        m_documentCache->remove(id);
+        onNoteChanged(id);
+    } catch (const Exception& e) {
+        showErrorDialog(e.error());
+    }
 }
 
 void MainWindow::showBirthdays() {
@@ -406,6 +655,11 @@ void MainWindow::showBirthdays() {
     birthdays->activateWindow();
 }
 
+void MainWindow::showDiagnostics() {
+    DiagnosticsDialog diagnosticsDialog(m_maintenance, m_database, this);
+    diagnosticsDialog.exec();
+}
+
 void MainWindow::about() {
     QMessageBox::about(this, tr("About %1").arg(Application::Name),
         tr("<h3>%1 %2</h3>"
@@ -418,40 +672,99 @@ void MainWindow::about() {
 }
 
 void MainWindow::onNoteChanged(Id id) {
+    Id previousId = m_editor->id();
+
+    // Document of the previous note is kept with its cursor and undo history, unless it is not loaded completely.
+    if (previousId && previousId != id && !m_editor->isLoading() && !m_editor->isRendering()) {
+        // Cached documents are dropped on eviction and on file change, so they hold only saved text.
+        if (m_editor->document()->isModified()) {
+            onEditorFocusLost();
+        }
+
+        m_documentCache->insert(previousId, m_editor->takeDocument());
+    }
+
     m_editor->setId(id);
     m_editor->setEnabled(id > 0);
 
-    m_findNextAction->setEnabled(false);
-    m_findPreviousAction->setEnabled(false);
-
-    if (id) {
-        bool markdown = m_database->noteValue(id, "markdown").toInt();
-        m_editor->setMode(markdown ? Editor::Mode::Markdown : Editor::Mode::Plain);
+    Editor::Snapshot snapshot;
 
-        QString note = m_database->noteValue(id, "note").toString();
-        m_editor->setNote(note);
+    if (id && m_documentCache->take(id, snapshot)) {
+        m_editor->restoreDocument(snapshot);
         m_editor->setFocus();
-
-        int line = m_database->noteValue(id, "line").toInt();
-        QTextCursor cursor = m_editor->textCursor();
-        cursor.movePosition(QTextCursor::NextBlock, QTextCursor::MoveAnchor, line);
-        m_editor->setTextCursor(cursor);
+    } else if (id) {
+        EditorState state = m_database->editorState(id);
+        m_editor->setNote(state.note, state.markdown ? Editor::Mode::Markdown : Editor::Mode::Plain, state.revision);
+        m_editor->setFocus();
+        m_editor->setLine(state.line);
     } else {
-        m_editor->clear();
+        m_editor->setNote(QString(), Editor::Mode::Plain);
     }
 }
 
+void MainWindow::onFilterChanged(const QString& text) {
+    if (!text.isEmpty()) {
+        m_noteFilter->setFilter(text);
+    }
+
+    m_noteFilter->setVisible(!text.isEmpty());
+    m_notetaking->setVisible(text.isEmpty());
+}
+
 void MainWindow::onEditorFocusLost() {
     Id lastId = m_editor->id();
 
-    if (!lastId) return;
+    if (!lastId || !m_database->isOpen()) return;
+
+    bool noteChanged = m_editor->document()->isModified() && !m_editor->isLoading();
+
+    EditorState state;
+    state.note = noteChanged ? m_editor->note() : QString();
+    state.line = m_editor->line();
+    state.markdown = m_editor->mode() == Editor::Mode::Markdown;
+
+    m_database->updateEditorState(lastId, state, noteChanged);
+
+    if (noteChanged) {
+        m_editor->document()->setModified(false);
+        m_editor->setSavedNote(state.note);
+        m_journal->markSaved(lastId);
+    }
+}
+
+void MainWindow::saveEditor() {
+    m_journalTimer->stop();
+
+    try {
+        onEditorFocusLost();
+    } catch (const Exception& e) {
+        showErrorDialog(e.error());
+    }
+}
+
+void MainWindow::onIdle() {
+    if (!m_database->isOpen()) return;
 
-    if (m_editor->document()->isModified()) {
-        m_database->updateNoteValue(lastId, "note", m_editor->note());
+    QDateTime maintainedAt = QDateTime::fromString(m_database->metaValue("maintained_at").toString(), "yyyy-MM-dd HH:mm:ss");
+
+    if (!maintainedAt.isValid() || maintainedAt.secsTo(QDateTime::currentDateTime()) > MaintenanceInterval) {
+        m_maintenance->run(m_database->filePath());
     }
+}
 
-    m_database->updateNoteValue(lastId, "line", m_editor->textCursor().blockNumber());
-    m_database->updateNoteValue(lastId, "markdown", m_editor->mode() == Editor::Mode::Markdown ? 1 : 0);
+void MainWindow::writeJournal() {
+    Id id = m_editor->id();
+
+    // Loaded and rendered text is already stored, only edits since the last save are journaled.
+    if (!id || !m_editor->document()->isModified() || m_editor->isLoading() || m_editor->mode() == Editor::Mode::Markdown) return;
+
+    if (m_editor->isLarge()) {
+        // Assembling a large note every interval is as slow as saving it, so only the edited range is written.
+        Editor::Change change = m_editor->change();
+        m_journal->appendChange(id, change.loadedSize, change.prefix, change.suffix, change.text);
+    } else {
+        m_journal->append(id, m_editor->note());
+    }
 }
 
 void MainWindow::onGlobalActivated() {
@@ -5,13 +5,20 @@
 class FileSettings;
 class RecentFilesMenu;
 class NoteTaking;
+class NoteFilter;
 class TrayIcon;
 class Editor;
+class FindBar;
+class DocumentCache;
 class Database;
 class GlobalHotkey;
 class HttpServerManager;
+class Maintenance;
+class RecoveryJournal;
 
 class QSplitter;
+class QLineEdit;
+class QTimer;
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
@@ -31,20 +38,28 @@ protected:
 private slots:
     void createFile();
     void open();
-    void exportAll();
+    void exportNotes();
+    void importDirectory();
+    void importArchive();
     void backup();
     void closeFile();
     void showPreferences();
     void find();
     void findInAllNotes();
+    void replaceInAllNotes();
+    void showHistory();
     void findNext();
     void findPrevious();
     void showBirthdays();
+    void showDiagnostics();
     void about();
 
     void onNoteChanged(Id id);
+    void onFilterChanged(const QString& text);
     void onEditorFocusLost();
     void onGlobalActivated();
+    void onIdle();
+    void writeJournal();
 
     void loadFile(const QString& filePath);
 
@@ -57,6 +72,9 @@ private:
     void createActions();
 
     void setCurrentFile(const QString& filePath = QString());
+    void importNotes(const QString& path);
+    void recoverNotes(const QString& filePath);
+    void saveEditor();
 
     void showErrorDialog(const QString& message);
     QString dateFileName(const QString& name);
@@ -69,11 +87,18 @@ private:
     QSplitter* m_splitter = nullptr;
 
     NoteTaking* m_notetaking = nullptr;
+    NoteFilter* m_noteFilter = nullptr;
+    QLineEdit* m_filterLineEdit = nullptr;
     Editor* m_editor = nullptr;
+    FindBar* m_findBar = nullptr;
     GlobalHotkey* m_globalHotkey = nullptr;
     Database* m_database = nullptr;
     HttpServerManager* m_serverManager = nullptr;
-    QString m_findText;
+    Maintenance* m_maintenance = nullptr;
+    DocumentCache* m_documentCache = nullptr;
+    RecoveryJournal* m_journal = nullptr;
+    QTimer* m_idleTimer = nullptr;
+    QTimer* m_journalTimer = nullptr;
 
     QMenu* m_editMenu = nullptr;
     QMenu* m_eventsMenu = nullptr;
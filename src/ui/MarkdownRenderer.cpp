@@ -0,0 +1,143 @@
+#include "MarkdownRenderer.h"
+#include "DocumentCache.h"
+#include <QtConcurrent>
+#include <QTextDocument>
+#include <QAbstractTextDocumentLayout>
+
+MarkdownRenderer::MarkdownRenderer(QObject* parent) : QObject(parent) {
+
+}
+
+MarkdownRenderer::~MarkdownRenderer() {
+    // Workers do not know about the renderer, so their documents are collected here.
+    for (auto watcher : std::as_const(m_watchers)) {
+        watcher->waitForFinished();
+        delete watcher->result();
+    }
+
+    clear();
+}
+
+void MarkdownRenderer::setLimit(qint64 bytes) {
+    m_limit = bytes;
+    evict();
+}
+
+qint64 MarkdownRenderer::size() const {
+    return m_size;
+}
+
+void MarkdownRenderer::render(Id id, Id revision, const QString& markdown, const QFont& font, qreal textWidth) {
+    if (m_pending.contains(id) && m_pending.value(id) == revision) return;
+
+    m_pending[id] = revision;
+
+    auto watcher = new QFutureWatcher<QTextDocument*>(this);
+    m_watchers.append(watcher);
+
+    // Superseded renders are not cancelled, their documents still go to the cache.
+    connect(watcher, &QFutureWatcher<QTextDocument*>::finished, this, [this, watcher, id, revision, generation = m_generation] {
+        m_watchers.removeOne(watcher);
+        watcher->deleteLater();
+
+        if (generation != m_generation) {
+            delete watcher->result();
+            return;
+        }
+
+        auto it = m_pending.find(id);
+
+        if (it != m_pending.end() && it.value() == revision) {
+            m_pending.erase(it);
+        }
+
+        insert(id, revision, watcher->result());
+        emit rendered(id);
+    });
+
+    watcher->setFuture(QtConcurrent::run(&MarkdownRenderer::renderDocument, markdown, font, textWidth, thread()));
+}
+
+bool MarkdownRenderer::isRendering(Id id) const {
+    return m_pending.contains(id);
+}
+
+QTextDocument* MarkdownRenderer::take(Id id, Id revision) {
+    auto it = m_entries.find(id);
+
+    if (it == m_entries.end()) {
+        return nullptr;
+    }
+
+    Entry entry = it.value();
+    m_size -= entry.cost;
+    m_entries.erase(it);
+    m_order.removeOne(id);
+
+    if (entry.revision != revision) {
+        delete entry.document;
+        return nullptr;
+    }
+
+    entry.document->setParent(nullptr);
+    return entry.document;
+}
+
+void MarkdownRenderer::insert(Id id, Id revision, QTextDocument* document) {
+    auto it = m_entries.find(id);
+
+    if (it != m_entries.end()) {
+        m_size -= it->cost;
+        delete it->document;
+        m_order.removeOne(id);
+    }
+
+    document->setParent(this);
+
+    Entry entry { revision, document, DocumentCache::cost(document) };
+    m_entries[id] = entry;
+    m_order.prepend(id);
+    m_size += entry.cost;
+
+    evict();
+}
+
+void MarkdownRenderer::clear() {
+    for (const Entry& entry : std::as_const(m_entries)) {
+        delete entry.document;
+    }
+
+    m_entries.clear();
+    m_order.clear();
+    m_size = 0;
+
+    m_pending.clear();
+    m_generation++;
+}
+
+int MarkdownRenderer::count() const {
+    return m_entries.count();
+}
+
+QTextDocument* MarkdownRenderer::renderDocument(const QString& markdown, const QFont& font, qreal textWidth, QThread* thread) {
+    auto document = new QTextDocument;
+    document->setDefaultFont(font);
+    document->setTextWidth(textWidth);
+    document->setMarkdown(markdown);
+
+    // Layout is the slow part for long notes, the editor reuses it when the width is the same.
+    document->documentLayout()->documentSize();
+
+    document->moveToThread(thread);
+    return document;
+}
+
+void MarkdownRenderer::evict() {
+    // Newest document is kept over the limit, the editor takes it once its render finishes.
+    while (m_size > m_limit && m_order.size() > 1) {
+        Id lastId = m_order.takeLast();
+        Entry entry = m_entries.take(lastId);
+        m_size -= entry.cost;
+        delete entry.document;
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "core/Globals.h"
+#include <QObject>
+#include <QHash>
+#include <QFont>
+
+class QTextDocument;
+class QThread;
+template <typename T> class QFutureWatcher;
+
+// Parses and lays out Markdown notes on a worker thread and keeps the rendered documents for re-viewing.
+// Documents are matched by the note id and the revision of its text, the caller keeps revisions unique per note.
+class MarkdownRenderer : public QObject {
+    Q_OBJECT
+public:
+    explicit MarkdownRenderer(QObject* parent = nullptr);
+    ~MarkdownRenderer() override;
+
+    void setLimit(qint64 bytes);
+    qint64 size() const;
+
+    void render(Id id, Id revision, const QString& markdown, const QFont& font, qreal textWidth);
+    bool isRendering(Id id) const;
+
+    QTextDocument* take(Id id, Id revision);
+    void insert(Id id, Id revision, QTextDocument* document);
+    void clear();
+    int count() const;
+
+    static QTextDocument* renderDocument(const QString& markdown, const QFont& font, qreal textWidth, QThread* thread);
+
+signals:
+    void rendered(Id id);
+
+private:
+    void evict();
+
+    struct Entry {
+        Id revision = 0;
+        QTextDocument* document = nullptr;
+        qint64 cost = 0;
+    };
+
+    QHash<Id, Entry> m_entries;
+    // Most recently used first.
+    QList<Id> m_order;
+    qint64 m_limit = 0;
+    qint64 m_size = 0;
+
+    QHash<Id, Id> m_pending;
+    QList<QFutureWatcher<QTextDocument*>*> m_watchers;
+    // Renders started before the cache was cleared are dropped when they finish.
+    int m_generation = 0;
+};
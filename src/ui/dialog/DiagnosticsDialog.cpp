@@ -0,0 +1,69 @@
+#include "DiagnosticsDialog.h"
+#include "database/Database.h"
+#include "database/Maintenance.h"
+#include <QLabel>
+#include <QTableWidget>
+#include <QHeaderView>
+#include <QPushButton>
+#include <QDialogButtonBox>
+#include <QFormLayout>
+#include <QFileInfo>
+#include <QLocale>
+
+DiagnosticsDialog::DiagnosticsDialog(Maintenance* maintenance, Database* database, QWidget* parent)
+    : StandardDialog(parent), m_maintenance(maintenance), m_database(database) {
+    setWindowTitle(tr("Database Diagnostics"));
+
+    m_fileSizeLabel = new QLabel;
+    m_maintainedAtLabel = new QLabel;
+
+    auto formLayout = new QFormLayout;
+    formLayout->addRow(tr("File size:"), m_fileSizeLabel);
+    formLayout->addRow(tr("Last maintenance:"), m_maintainedAtLabel);
+
+    m_table = new QTableWidget(0, 3);
+    m_table->setHorizontalHeaderLabels({ tr("Task"), tr("Result"), tr("Time, ms") });
+    m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_table->horizontalHeader()->setStretchLastSection(true);
+    m_table->verticalHeader()->setVisible(false);
+
+    auto verticalLayout = new QVBoxLayout;
+    verticalLayout->addLayout(formLayout);
+    verticalLayout->addWidget(m_table, 1);
+
+    setContentLayout(verticalLayout, false);
+    resizeToWidth(500);
+
+    m_runButton = new QPushButton(tr("Run Now"));
+    connect(m_runButton, &QPushButton::clicked, this, [this] {
+        m_maintenance->run(m_database->filePath());
+    });
+
+    buttonBox()->setStandardButtons(QDialogButtonBox::Close);
+    buttonBox()->addButton(m_runButton, QDialogButtonBox::ActionRole);
+
+    connect(m_maintenance, &Maintenance::started, this, &DiagnosticsDialog::load);
+    connect(m_maintenance, &Maintenance::finished, this, &DiagnosticsDialog::load);
+
+    load();
+}
+
+void DiagnosticsDialog::load() {
+    m_fileSizeLabel->setText(QLocale().formattedDataSize(QFileInfo(m_database->filePath()).size()));
+
+    QString maintainedAt = m_database->metaValue("maintained_at").toString();
+    m_maintainedAtLabel->setText(m_maintenance->isRunning() ? tr("Running...") : maintainedAt.isEmpty() ? tr("Never") : maintainedAt);
+    m_runButton->setEnabled(!m_maintenance->isRunning());
+
+    m_table->setRowCount(0);
+
+    for (const auto& task : m_maintenance->tasks()) {
+        int row = m_table->rowCount();
+        m_table->insertRow(row);
+        m_table->setItem(row, 0, new QTableWidgetItem(task.name));
+        m_table->setItem(row, 1, new QTableWidgetItem(task.result));
+        m_table->setItem(row, 2, new QTableWidgetItem(QString::number(task.elapsed)));
+    }
+
+    m_table->resizeColumnsToContents();
+}
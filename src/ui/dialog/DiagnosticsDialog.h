@@ -0,0 +1,27 @@
+#pragma once
+#include "StandardDialog.h"
+
+class Maintenance;
+class Database;
+
+class QLabel;
+class QTableWidget;
+class QPushButton;
+
+class DiagnosticsDialog : public StandardDialog {
+    Q_OBJECT
+public:
+    DiagnosticsDialog(Maintenance* maintenance, Database* database, QWidget* parent = nullptr);
+
+private slots:
+    void load();
+
+private:
+    Maintenance* m_maintenance = nullptr;
+    Database* m_database = nullptr;
+
+    QLabel* m_fileSizeLabel = nullptr;
+    QLabel* m_maintainedAtLabel = nullptr;
+    QTableWidget* m_table = nullptr;
+    QPushButton* m_runButton = nullptr;
+};
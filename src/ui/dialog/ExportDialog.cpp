@@ -0,0 +1,44 @@
+#include "ExportDialog.h"
+#include <QComboBox>
+#include <QCheckBox>
+#include <QFormLayout>
+
+ExportDialog::ExportDialog(int selectedCount, QWidget* parent) : StandardDialog(parent) {
+    setWindowTitle(tr("Export"));
+
+    m_scopeComboBox = new QComboBox;
+    m_scopeComboBox->addItem(tr("All notes"));
+
+    if (selectedCount == 1) {
+        m_scopeComboBox->addItem(tr("Selected note"));
+    } else if (selectedCount > 1) {
+        m_scopeComboBox->addItem(tr("Selected notes (%1)").arg(selectedCount));
+    }
+
+    m_formatComboBox = new QComboBox;
+    m_formatComboBox->addItem(tr("Text"), int(Exporter::Format::Text));
+    m_formatComboBox->addItem("Markdown", int(Exporter::Format::Markdown));
+    m_formatComboBox->addItem("HTML", int(Exporter::Format::Html));
+
+    m_syncCheckBox = new QCheckBox(tr("Sync to folder (write only changed notes)"));
+
+    auto formLayout = new QFormLayout;
+    formLayout->addRow(tr("Notes:"), m_scopeComboBox);
+    formLayout->addRow(tr("Format:"), m_formatComboBox);
+    formLayout->addRow(m_syncCheckBox);
+
+    setContentLayout(formLayout);
+    resizeToWidth(400);
+}
+
+bool ExportDialog::selectedOnly() const {
+    return m_scopeComboBox->currentIndex() == 1;
+}
+
+Exporter::Format ExportDialog::format() const {
+    return Exporter::Format(m_formatComboBox->currentData().toInt());
+}
+
+bool ExportDialog::syncToFolder() const {
+    return m_syncCheckBox->isChecked();
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include "StandardDialog.h"
+#include "core/Exporter.h"
+
+class QComboBox;
+class QCheckBox;
+
+class ExportDialog : public StandardDialog {
+    Q_OBJECT
+public:
+    ExportDialog(int selectedCount, QWidget* parent = nullptr);
+
+    bool selectedOnly() const;
+    Exporter::Format format() const;
+    bool syncToFolder() const;
+
+private:
+    QComboBox* m_scopeComboBox = nullptr;
+    QComboBox* m_formatComboBox = nullptr;
+    QCheckBox* m_syncCheckBox = nullptr;
+};
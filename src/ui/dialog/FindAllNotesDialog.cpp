@@ -6,54 +6,197 @@
 #include <QPushButton>
 #include <QDialogButtonBox>
 #include <QFormLayout>
+#include <QGridLayout>
+#include <QTimer>
+#include <QCheckBox>
+#include <QComboBox>
+#include <QRegularExpression>
 
-FindAllNotesDialog::FindAllNotesDialog(Database* database) : m_database(database) {
-    setWindowTitle(tr("Find in All Notes"));
+constexpr auto DebounceInterval = 250;
+constexpr auto ScoreRole = Qt::UserRole + 1;
+
+FindAllNotesDialog::FindAllNotesDialog(Database* database, Id currentId, Mode mode) :
+        m_database(database), m_currentId(currentId), m_mode(mode) {
+    setWindowTitle(mode == Mode::Find ? tr("Find in All Notes") : tr("Replace in All Notes"));
 
     m_lineEdit = new QLineEdit;
     m_listWidget = new QListWidget;
+    m_statusLabel = new QLabel;
+
+    m_fieldComboBox = new QComboBox;
+    m_fieldComboBox->addItem(tr("Titles and Notes"), int(Search::Field::All));
+    m_fieldComboBox->addItem(tr("Titles"), int(Search::Field::Title));
+    m_fieldComboBox->addItem(tr("Notes"), int(Search::Field::Note));
+
+    m_regexCheckBox = new QCheckBox(tr("Regular expression"));
+    m_wholeWordsCheckBox = new QCheckBox(tr("Whole words"));
+    m_caseSensitiveCheckBox = new QCheckBox(tr("Case sensitive"));
+    m_subtreeCheckBox = new QCheckBox(tr("Current note and its children"));
+    m_subtreeCheckBox->setEnabled(currentId != 0);
 
     auto formLayout = new QFormLayout;
     formLayout->addRow(new QLabel(tr("Text:")), m_lineEdit);
 
+    if (mode == Mode::Replace) {
+        m_replaceLineEdit = new QLineEdit;
+        formLayout->addRow(new QLabel(tr("Replace with:")), m_replaceLineEdit);
+    }
+
+    formLayout->addRow(new QLabel(tr("Search in:")), m_fieldComboBox);
+
+    auto optionsLayout = new QGridLayout;
+    optionsLayout->addWidget(m_regexCheckBox, 0, 0);
+    optionsLayout->addWidget(m_wholeWordsCheckBox, 0, 1);
+    optionsLayout->addWidget(m_caseSensitiveCheckBox, 1, 0);
+    optionsLayout->addWidget(m_subtreeCheckBox, 1, 1);
+
     auto verticalLayout = new QVBoxLayout;
     verticalLayout->addLayout(formLayout);
+    verticalLayout->addLayout(optionsLayout);
     verticalLayout->addWidget(m_listWidget, 1);
+    verticalLayout->addWidget(m_statusLabel);
 
     setContentLayout(verticalLayout, false);
     resizeToWidth(500);
 
-    auto findButton = new QPushButton(tr("Find"));
-    findButton->setEnabled(false);
-    findButton->setDefault(true);
-    connect(findButton, &QPushButton::clicked, this, &FindAllNotesDialog::find);
-
-    buttonBox()->addButton(findButton, QDialogButtonBox::ActionRole);
     buttonBox()->button(QDialogButtonBox::Ok)->setEnabled(false);
 
-    connect(m_lineEdit, &QLineEdit::textChanged, this, [=] (const QString& text) {
-        findButton->setEnabled(!text.isEmpty());
-    });
+    if (mode == Mode::Replace) {
+        buttonBox()->button(QDialogButtonBox::Ok)->setText(tr("Replace All"));
+    }
+
+    m_search = new Search(this);
+    connect(m_search, &Search::found, this, &FindAllNotesDialog::onFound);
+    connect(m_search, &Search::finished, this, &FindAllNotesDialog::onFinished);
+
+    m_debounceTimer = new QTimer(this);
+    m_debounceTimer->setSingleShot(true);
+    m_debounceTimer->setInterval(DebounceInterval);
+    connect(m_debounceTimer, &QTimer::timeout, this, &FindAllNotesDialog::find);
+
+    connect(m_lineEdit, &QLineEdit::textChanged, this, &FindAllNotesDialog::onTextChanged);
+    connect(m_fieldComboBox, &QComboBox::currentIndexChanged, this, &FindAllNotesDialog::onTextChanged);
 
-    connect(m_listWidget, &QListWidget::currentRowChanged, this, [this] (int currentRow) {
-        buttonBox()->button(QDialogButtonBox::Ok)->setEnabled(currentRow >= 0);
-    });
+    for (QCheckBox* checkBox : { m_regexCheckBox, m_wholeWordsCheckBox, m_caseSensitiveCheckBox, m_subtreeCheckBox }) {
+        connect(checkBox, &QCheckBox::toggled, this, &FindAllNotesDialog::onTextChanged);
+    }
+
+    if (mode == Mode::Find) {
+        connect(m_listWidget, &QListWidget::currentRowChanged, this, [this] (int currentRow) {
+            buttonBox()->button(QDialogButtonBox::Ok)->setEnabled(currentRow >= 0);
+        });
 
-    connect(m_listWidget, &QListWidget::doubleClicked, this, &FindAllNotesDialog::accept);
+        connect(m_listWidget, &QListWidget::doubleClicked, this, &FindAllNotesDialog::accept);
+    }
 
     m_lineEdit->setFocus();
 }
 
-Id FindAllNotesDialog::noteId() const {
-    return m_listWidget->currentItem()->data(Qt::UserRole).toInt();
+FindNote FindAllNotesDialog::findNote() const {
+    return m_notes.at(m_listWidget->currentItem()->data(Qt::UserRole).toInt());
+}
+
+Ids FindAllNotesDialog::noteIds() const {
+    Ids result;
+
+    for (const FindNote& note : m_notes) {
+        result.append(note.id);
+    }
+
+    return result;
+}
+
+Search::Options FindAllNotesDialog::options() const {
+    Search::Options result;
+    result.text = m_lineEdit->text();
+    result.regex = m_regexCheckBox->isChecked();
+    result.wholeWords = m_wholeWordsCheckBox->isChecked();
+    result.caseSensitive = m_caseSensitiveCheckBox->isChecked();
+    result.field = Search::Field(m_fieldComboBox->currentData().toInt());
+    result.rootId = m_subtreeCheckBox->isChecked() ? m_currentId : 0;
+    result.countAll = m_mode == Mode::Replace;
+
+    return result;
+}
+
+QString FindAllNotesDialog::replacement() const {
+    return m_replaceLineEdit ? m_replaceLineEdit->text() : QString();
 }
 
 void FindAllNotesDialog::find() {
     m_listWidget->clear();
-    QVector<FindNote> findNotes = m_database->find(m_lineEdit->text());
+    m_notes.clear();
+    buttonBox()->button(QDialogButtonBox::Ok)->setEnabled(false);
+
+    Search::Options options = this->options();
+    QRegularExpression regex = Search::regularExpression(options);
+
+    if (!regex.isValid()) {
+        m_search->cancel();
+        m_statusLabel->setText(tr("Invalid regular expression: %1").arg(regex.errorString()));
+        return;
+    }
+
+    m_statusLabel->setText(tr("Searching..."));
+    m_search->start(m_database->filePath(), options);
+}
+
+void FindAllNotesDialog::onTextChanged() {
+    if (m_mode == Mode::Replace) {
+        buttonBox()->button(QDialogButtonBox::Ok)->setEnabled(false);
+    }
+
+    if (m_lineEdit->text().isEmpty()) {
+        m_debounceTimer->stop();
+        m_search->cancel();
+        m_listWidget->clear();
+        m_notes.clear();
+        m_statusLabel->clear();
+    } else {
+        m_debounceTimer->start();
+    }
+}
 
-    for (const auto& note : findNotes) {
-        auto item = new QListWidgetItem(note.title, m_listWidget);
-        item->setData(Qt::UserRole, note.id);
+void FindAllNotesDialog::onFound(const QVector<FindNote>& notes) {
+    for (const auto& note : notes) {
+        QString title = m_mode == Mode::Find ? note.title : tr("%1 (matches: %2)").arg(note.title).arg(note.matchCount);
+        auto item = new QListWidgetItem(title + "\n" + note.snippet);
+        item->setData(Qt::UserRole, m_notes.count());
+        item->setData(ScoreRole, note.score);
+        m_notes.append(note);
+
+        // Results arrive in table order, keep the list sorted by score.
+        int first = 0;
+        int last = m_listWidget->count();
+
+        while (first < last) {
+            int middle = (first + last) / 2;
+
+            if (m_listWidget->item(middle)->data(ScoreRole).toInt() >= note.score) {
+                first = middle + 1;
+            } else {
+                last = middle;
+            }
+        }
+
+        m_listWidget->insertItem(first, item);
+    }
+
+    m_statusLabel->setText(tr("Searching... Found: %1").arg(m_listWidget->count()));
+}
+
+void FindAllNotesDialog::onFinished(int count, qint64 elapsed) {
+    if (m_mode == Mode::Find) {
+        m_statusLabel->setText(tr("Found: %1 (%2 ms)").arg(count).arg(elapsed));
+        return;
+    }
+
+    int matchCount = 0;
+
+    for (const FindNote& note : m_notes) {
+        matchCount += note.matchCount;
     }
+
+    m_statusLabel->setText(tr("Notes: %1, matches: %2 (%3 ms)").arg(count).arg(matchCount).arg(elapsed));
+    buttonBox()->button(QDialogButtonBox::Ok)->setEnabled(count > 0);
 }
@@ -1,24 +1,52 @@
 #pragma once
 #include "StandardDialog.h"
-#include "core/Globals.h"
+#include "database/Search.h"
 
 class Database;
 
 class QLineEdit;
 class QListWidget;
+class QLabel;
+class QTimer;
+class QCheckBox;
+class QComboBox;
 
 class FindAllNotesDialog : public StandardDialog {
     Q_OBJECT
 public:
-    FindAllNotesDialog(Database* database);
-    Id noteId() const;
+    enum class Mode {
+        Find,
+        Replace
+    };
+
+    FindAllNotesDialog(Database* database, Id currentId = 0, Mode mode = Mode::Find);
+
+    FindNote findNote() const;
+    Ids noteIds() const;
+    Search::Options options() const;
+    QString replacement() const;
 
 private slots:
     void find();
+    void onTextChanged();
+    void onFound(const QVector<FindNote>& notes);
+    void onFinished(int count, qint64 elapsed);
 
 private:
     Database* m_database = nullptr;
+    Id m_currentId = 0;
+    Mode m_mode = Mode::Find;
+    Search* m_search = nullptr;
+    QVector<FindNote> m_notes;
 
     QLineEdit* m_lineEdit = nullptr;
+    QLineEdit* m_replaceLineEdit = nullptr;
     QListWidget* m_listWidget = nullptr;
+    QLabel* m_statusLabel = nullptr;
+    QCheckBox* m_regexCheckBox = nullptr;
+    QCheckBox* m_wholeWordsCheckBox = nullptr;
+    QCheckBox* m_caseSensitiveCheckBox = nullptr;
+    QCheckBox* m_subtreeCheckBox = nullptr;
+    QComboBox* m_fieldComboBox = nullptr;
+    QTimer* m_debounceTimer = nullptr;
 };
@@ -0,0 +1,74 @@
+#include "HistoryDialog.h"
+#include "database/Database.h"
+#include <QTableWidget>
+#include <QHeaderView>
+#include <QPlainTextEdit>
+#include <QSplitter>
+#include <QPushButton>
+#include <QDialogButtonBox>
+#include <QVBoxLayout>
+#include <QLocale>
+
+HistoryDialog::HistoryDialog(Database* database, Id noteId, QWidget* parent)
+    : StandardDialog(parent), m_database(database) {
+    setWindowTitle(tr("Note History"));
+
+    m_revisions = database->revisions(noteId);
+
+    m_table = new QTableWidget(0, 3);
+    m_table->setHorizontalHeaderLabels({ tr("Saved"), tr("Size"), tr("Stored") });
+    m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_table->setSelectionMode(QAbstractItemView::SingleSelection);
+    m_table->horizontalHeader()->setStretchLastSection(true);
+    m_table->verticalHeader()->setVisible(false);
+
+    QLocale locale;
+
+    for (const Revision& revision : std::as_const(m_revisions)) {
+        int row = m_table->rowCount();
+        m_table->insertRow(row);
+        m_table->setItem(row, 0, new QTableWidgetItem(revision.createdAt));
+        m_table->setItem(row, 1, new QTableWidgetItem(tr("%n character(s)", nullptr, revision.size)));
+        m_table->setItem(row, 2, new QTableWidgetItem(locale.formattedDataSize(revision.storedSize)));
+    }
+
+    m_table->resizeColumnsToContents();
+
+    m_textEdit = new QPlainTextEdit;
+    m_textEdit->setReadOnly(true);
+
+    auto splitter = new QSplitter;
+    splitter->addWidget(m_table);
+    splitter->addWidget(m_textEdit);
+    splitter->setStretchFactor(1, 1);
+
+    auto verticalLayout = new QVBoxLayout;
+    verticalLayout->addWidget(splitter, 1);
+
+    setContentLayout(verticalLayout, false);
+    resizeToWidth(800);
+
+    buttonBox()->button(QDialogButtonBox::Ok)->setText(tr("Restore"));
+    buttonBox()->button(QDialogButtonBox::Ok)->setEnabled(false);
+
+    connect(m_table, &QTableWidget::currentCellChanged, this, &HistoryDialog::onCurrentRowChanged);
+
+    if (!m_revisions.isEmpty()) {
+        m_table->setCurrentCell(0, 0);
+    }
+}
+
+QString HistoryDialog::text() const {
+    return m_text;
+}
+
+void HistoryDialog::onCurrentRowChanged() {
+    int row = m_table->currentRow();
+    bool selected = row >= 0 && row < m_revisions.count();
+
+    // Each revision is rebuilt from its nearest keyframe, so only the selected one is read.
+    m_text = selected ? m_database->revisionText(m_revisions.at(row).id) : QString();
+    m_textEdit->setPlainText(m_text);
+    buttonBox()->button(QDialogButtonBox::Ok)->setEnabled(selected);
+}
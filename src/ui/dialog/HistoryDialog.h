@@ -0,0 +1,27 @@
+#pragma once
+#include "StandardDialog.h"
+#include "core/Model.h"
+
+class Database;
+
+class QTableWidget;
+class QPlainTextEdit;
+
+class HistoryDialog : public StandardDialog {
+    Q_OBJECT
+public:
+    HistoryDialog(Database* database, Id noteId, QWidget* parent = nullptr);
+
+    QString text() const;
+
+private slots:
+    void onCurrentRowChanged();
+
+private:
+    Database* m_database = nullptr;
+    QVector<Revision> m_revisions;
+    QString m_text;
+
+    QTableWidget* m_table = nullptr;
+    QPlainTextEdit* m_textEdit = nullptr;
+};
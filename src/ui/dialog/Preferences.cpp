@@ -6,6 +6,7 @@
 #include <QComboBox>
 #include <QMessageBox>
 #include <QCheckBox>
+#include <QSpinBox>
 #include <QLineEdit>
 #include <QPushButton>
 #include <QFontDialog>
@@ -23,6 +24,8 @@ Preferences::Preferences(Settings* settings, QWidget* parent)
     layout->addWidget(createHotkeyGroupBox());
     layout->addWidget(createBackupsGroupBox());
     layout->addWidget(createServerGroupBox());
+    layout->addWidget(createDatabaseGroupBox());
+    layout->addWidget(createEditorGroupBox());
     layout->addStretch(1);
 
     setContentLayout(layout);
@@ -54,6 +57,11 @@ void Preferences::accept() {
     m_settings->setServerCertificate(m_certificateBrowseLayout->text());
     m_settings->setServerPrivateKey(m_privateKeyBrowseLayout->text());
 
+    m_settings->setDatabaseCompressNotes(m_compressNotesCheckBox->isChecked());
+    m_settings->setDatabaseHistoryDays(m_historyDaysSpinBox->value());
+    m_settings->setDatabaseHistoryRevisions(m_historyRevisionsSpinBox->value());
+    m_settings->setEditorCacheSize(m_cacheSizeSpinBox->value());
+
     QDialog::accept();
 }
 
@@ -207,3 +215,48 @@ QGroupBox* Preferences::createServerGroupBox() {
 
     return m_serverGroupBox;
 }
+
+QGroupBox* Preferences::createDatabaseGroupBox() {
+    m_compressNotesCheckBox = new QCheckBox(tr("Compress large notes"));
+    m_compressNotesCheckBox->setChecked(m_settings->databaseCompressNotes());
+
+    m_historyDaysSpinBox = new QSpinBox;
+    m_historyDaysSpinBox->setRange(0, 3650);
+    m_historyDaysSpinBox->setSuffix(tr(" days"));
+    m_historyDaysSpinBox->setSpecialValueText(tr("Forever"));
+    m_historyDaysSpinBox->setValue(m_settings->databaseHistoryDays());
+
+    m_historyRevisionsSpinBox = new QSpinBox;
+    m_historyRevisionsSpinBox->setRange(0, 10000);
+    m_historyRevisionsSpinBox->setSpecialValueText(tr("Unlimited"));
+    m_historyRevisionsSpinBox->setValue(m_settings->databaseHistoryRevisions());
+
+    auto formLayout = new QFormLayout;
+    formLayout->addRow(tr("Keep note history:"), m_historyDaysSpinBox);
+    formLayout->addRow(tr("Revisions per note:"), m_historyRevisionsSpinBox);
+    formLayout->itemAt(formLayout->indexOf(m_historyDaysSpinBox))->setAlignment(Qt::AlignLeft);
+    formLayout->itemAt(formLayout->indexOf(m_historyRevisionsSpinBox))->setAlignment(Qt::AlignLeft);
+
+    auto result = new QGroupBox(tr("Database"));
+    auto verticalLayout = new QVBoxLayout(result);
+    verticalLayout->addWidget(m_compressNotesCheckBox);
+    verticalLayout->addLayout(formLayout);
+
+    return result;
+}
+
+QGroupBox* Preferences::createEditorGroupBox() {
+    m_cacheSizeSpinBox = new QSpinBox;
+    m_cacheSizeSpinBox->setRange(0, 4096);
+    m_cacheSizeSpinBox->setSuffix(tr(" MB"));
+    m_cacheSizeSpinBox->setValue(m_settings->editorCacheSize());
+
+    auto formLayout = new QFormLayout;
+    formLayout->addRow(tr("Cache of recent notes:"), m_cacheSizeSpinBox);
+    formLayout->itemAt(formLayout->indexOf(m_cacheSizeSpinBox))->setAlignment(Qt::AlignLeft);
+
+    auto result = new QGroupBox(tr("Editor"));
+    result->setLayout(formLayout);
+
+    return result;
+}
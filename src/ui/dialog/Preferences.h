@@ -8,6 +8,7 @@ class QComboBox;
 class QLineEdit;
 class QCheckBox;
 class QGroupBox;
+class QSpinBox;
 
 class Preferences : public StandardDialog {
     Q_OBJECT
@@ -26,6 +27,8 @@ private:
     QGroupBox* createHotkeyGroupBox();
     QGroupBox* createBackupsGroupBox();
     QGroupBox* createServerGroupBox();
+    QGroupBox* createDatabaseGroupBox();
+    QGroupBox* createEditorGroupBox();
 
     Settings* m_settings = nullptr;
 
@@ -46,4 +49,9 @@ private:
     QGroupBox* m_sslGroupBox = nullptr;
     BrowseLayout* m_certificateBrowseLayout = nullptr;
     BrowseLayout* m_privateKeyBrowseLayout = nullptr;
+
+    QCheckBox* m_compressNotesCheckBox = nullptr;
+    QSpinBox* m_historyDaysSpinBox = nullptr;
+    QSpinBox* m_historyRevisionsSpinBox = nullptr;
+    QSpinBox* m_cacheSizeSpinBox = nullptr;
 };
@@ -0,0 +1,131 @@
+#include "FilterModel.h"
+#include "TitleIndex.h"
+#include <QFont>
+
+FilterModel::FilterModel(QObject* parent) : QAbstractItemModel(parent), m_nodes(1) {
+
+}
+
+QModelIndex FilterModel::index(int row, int column, const QModelIndex& parent) const {
+    if (parent.isValid() && parent.column() != 0) {
+        return QModelIndex();
+    }
+
+    const Node& parentNode = m_nodes.at(parent.isValid() ? parent.internalId() : 0);
+
+    if (row < 0 || row >= parentNode.children.count() || column != 0) {
+        return QModelIndex();
+    }
+
+    return createIndex(row, column, quintptr(parentNode.children.at(row)));
+}
+
+QModelIndex FilterModel::parent(const QModelIndex& child) const {
+    if (!child.isValid()) {
+        return QModelIndex();
+    }
+
+    int parent = m_nodes.at(child.internalId()).parent;
+
+    if (parent == 0) {
+        return QModelIndex();
+    }
+
+    return createIndex(m_nodes.at(parent).row, 0, quintptr(parent));
+}
+
+int FilterModel::rowCount(const QModelIndex& parent) const {
+    if (parent.column() > 0) {
+        return 0;
+    }
+
+    return m_nodes.at(parent.isValid() ? parent.internalId() : 0).children.count();
+}
+
+int FilterModel::columnCount(const QModelIndex& parent [[maybe_unused]]) const {
+    return 1;
+}
+
+QVariant FilterModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid()) {
+        return QVariant();
+    }
+
+    const Node& node = m_nodes.at(index.internalId());
+
+    if (role == Qt::DisplayRole) {
+        return m_titleIndex->entry(node.slot).title;
+    }
+
+    if (role == Qt::FontRole && node.matched) {
+        QFont font;
+        font.setBold(true);
+        return font;
+    }
+
+    return QVariant();
+}
+
+void FilterModel::setResult(const TitleIndex* titleIndex, const QVector<int>& visibleSlots, const QVector<int>& matches) {
+    beginResetModel();
+
+    m_titleIndex = titleIndex;
+    m_nodes.resize(1);
+    m_nodes[0].children.clear();
+
+    QHash<int, int> nodes;
+    nodes.reserve(visibleSlots.count());
+
+    for (int slot : visibleSlots) {
+        Node node;
+        node.slot = slot;
+        nodes[slot] = m_nodes.count();
+        m_nodes.append(node);
+    }
+
+    for (int slot : matches) {
+        m_nodes[nodes.value(slot)].matched = true;
+    }
+
+    // Slots are sorted, so siblings keep the order in which they were indexed.
+    for (int i = 1; i < m_nodes.count(); i++) {
+        Node& node = m_nodes[i];
+        int parentSlot = titleIndex->slot(titleIndex->entry(node.slot).parentId);
+        node.parent = nodes.value(parentSlot, 0);
+
+        Node& parentNode = m_nodes[node.parent];
+        node.row = parentNode.children.count();
+        parentNode.children.append(i);
+    }
+
+    endResetModel();
+}
+
+void FilterModel::clear() {
+    beginResetModel();
+    m_nodes.resize(1);
+    m_nodes[0].children.clear();
+    endResetModel();
+}
+
+Id FilterModel::id(const QModelIndex& index) const {
+    if (!index.isValid()) {
+        return 0;
+    }
+
+    return m_titleIndex->entry(m_nodes.at(index.internalId()).slot).id;
+}
+
+QModelIndex FilterModel::find(Id id) const {
+    for (int i = 1; i < m_nodes.count(); i++) {
+        if (m_titleIndex->entry(m_nodes.at(i).slot).id == id) {
+            return createIndex(m_nodes.at(i).row, 0, quintptr(i));
+        }
+    }
+
+    return QModelIndex();
+}
+
+int FilterModel::count() const {
+    return m_nodes.count() - 1;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include "core/Globals.h"
+#include <QAbstractItemModel>
+
+class TitleIndex;
+
+class FilterModel : public QAbstractItemModel {
+    Q_OBJECT
+public:
+    FilterModel(QObject* parent = nullptr);
+
+    QModelIndex index(int row, int column, const QModelIndex& parent) const override;
+    QModelIndex parent(const QModelIndex& child) const override;
+    int rowCount(const QModelIndex& parent) const override;
+    int columnCount(const QModelIndex& parent) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+    void setResult(const TitleIndex* titleIndex, const QVector<int>& visibleSlots, const QVector<int>& matches);
+    void clear();
+
+    Id id(const QModelIndex& index) const;
+    QModelIndex find(Id id) const;
+    int count() const;
+
+private:
+    struct Node {
+        int slot = -1;
+        int parent = 0;
+        int row = 0;
+        bool matched = false;
+        QVector<int> children;
+    };
+
+    // Node 0 is the invisible root, model indexes keep node numbers as internal ids.
+    QVector<Node> m_nodes;
+    const TitleIndex* m_titleIndex = nullptr;
+};
@@ -0,0 +1,105 @@
+#include "NoteFilter.h"
+#include "FilterModel.h"
+#include "database/Database.h"
+#include "database/DatabaseException.h"
+#include <QHeaderView>
+
+constexpr auto ExpandLimit = 1000;
+
+NoteFilter::NoteFilter(Database* database) : m_database(database) {
+    header()->setVisible(false);
+    setSelectionMode(QAbstractItemView::SingleSelection);
+    setEditTriggers(QAbstractItemView::NoEditTriggers);
+    setUniformRowHeights(true);
+
+    m_model = new FilterModel(this);
+    setModel(m_model);
+}
+
+void NoteFilter::setFilter(const QString& text) {
+    if (!m_isBuilt) {
+        build();
+    }
+
+    m_text = text;
+    Id currentId = m_model->id(currentIndex());
+
+    QVector<int> matches = m_titleIndex.match(text);
+    QVector<int> visibleSlots = m_titleIndex.visibleSlots(matches);
+
+    m_isUpdating = true;
+    m_model->setResult(&m_titleIndex, visibleSlots, matches);
+
+    // Expanding a huge result costs more than it helps while typing the first letters.
+    if (m_model->count() <= ExpandLimit) {
+        expandAll();
+    }
+
+    if (currentId) {
+        setCurrentIndex(m_model->find(currentId));
+    }
+
+    m_isUpdating = false;
+}
+
+void NoteFilter::invalidate() {
+    m_isBuilt = false;
+    m_titleIndex.clear();
+    m_model->clear();
+}
+
+void NoteFilter::addNote(Id id, Id parentId, const QString& title) {
+    if (m_isBuilt) {
+        m_titleIndex.insert(id, parentId, title);
+    }
+}
+
+void NoteFilter::renameNote(Id id, const QString& title) {
+    if (m_isBuilt) {
+        m_titleIndex.rename(id, title);
+    }
+}
+
+void NoteFilter::moveNote(Id id, Id parentId) {
+    if (m_isBuilt) {
+        m_titleIndex.move(id, parentId);
+    }
+}
+
+void NoteFilter::removeNotes(const Ids& ids) {
+    if (!m_isBuilt) return;
+
+    m_model->clear();
+
+    for (Id id : ids) {
+        m_titleIndex.remove(id);
+    }
+
+    // Result held the removed notes, it is rebuilt for the same text while shown.
+    if (isVisible() && !m_text.isEmpty()) {
+        setFilter(m_text);
+    }
+}
+
+void NoteFilter::currentChanged(const QModelIndex& current, const QModelIndex& previous) {
+    QTreeView::currentChanged(current, previous);
+
+    if (m_isUpdating || !current.isValid()) return;
+
+    emit noteActivated(m_model->id(current));
+}
+
+void NoteFilter::build() {
+    m_titleIndex.clear();
+
+    try {
+        // Notes come ordered by depth and position, so do the slots of the index.
+        for (const Note& note : m_database->noteHeaders()) {
+            m_titleIndex.insert(note.id, note.parentId, note.title);
+        }
+    } catch (const SqlQueryError& e) {
+        qCritical() << "Error build title index: " << e.error();
+    }
+
+    m_isBuilt = true;
+}
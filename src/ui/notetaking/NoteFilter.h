@@ -0,0 +1,39 @@
+#pragma once
+#include <QTreeView>
+#include "core/Model.h"
+#include "TitleIndex.h"
+
+class Database;
+class FilterModel;
+
+// Shows notes whose titles match the filter text, with their parents, from an in-memory title index.
+class NoteFilter : public QTreeView {
+    Q_OBJECT
+public:
+    NoteFilter(Database* database);
+
+    void setFilter(const QString& text);
+
+public slots:
+    void invalidate();
+    void addNote(Id id, Id parentId, const QString& title);
+    void renameNote(Id id, const QString& title);
+    void moveNote(Id id, Id parentId);
+    void removeNotes(const Ids& ids);
+
+signals:
+    void noteActivated(Id id);
+
+protected slots:
+    void currentChanged(const QModelIndex& current, const QModelIndex& previous) override;
+
+private:
+    void build();
+
+    Database* m_database = nullptr;
+    FilterModel* m_model = nullptr;
+    TitleIndex m_titleIndex;
+    QString m_text;
+    bool m_isBuilt = false;
+    bool m_isUpdating = false;
+};
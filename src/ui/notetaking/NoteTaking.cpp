@@ -10,8 +10,10 @@
 #include <QLineEdit>
 #include <QInputDialog>
 #include <QMessageBox>
-#include <QDir>
 #include <QMouseEvent>
+#include <QTimer>
+
+constexpr auto SelectionSaveInterval = 1000;
 
 NoteTaking::NoteTaking(Database* database) : m_database(database) {
     setContextMenuPolicy(Qt::CustomContextMenu);
@@ -22,30 +24,30 @@ NoteTaking::NoteTaking(Database* database) : m_database(database) {
     setAcceptDrops(true);
     setDropIndicatorShown(true);
     setDragDropMode(QAbstractItemView::InternalMove);
-    setSelectionMode(QAbstractItemView::SingleSelection);
+    setSelectionMode(QAbstractItemView::ExtendedSelection);
+
+    m_selectionTimer = new QTimer(this);
+    m_selectionTimer->setSingleShot(true);
+    m_selectionTimer->setInterval(SelectionSaveInterval);
+    connect(m_selectionTimer, &QTimer::timeout, this, &NoteTaking::saveSelectedId);
 
     clear();
 
     connect(itemDelegate(), &QAbstractItemDelegate::closeEditor, this, [=, this] {
         TreeItem* item = m_model->item(selectionModel()->currentIndex());
-        database->updateNoteValue(item->id(), "title", item->data());
+        database->updateNoteValue(item->id(), "title", item->title());
+        emit noteRenamed(item->id(), item->title());
     });
 }
 
 void NoteTaking::build() {
     clear();
-    QVector<Note> notes = m_database->notes();
     int selectedId = m_database->metaValue("selected_id").toInt();
+    m_selectedId = selectedId;
+    m_savedSelectedId = selectedId;
 
-    for (const Note& note : notes) {
-        TreeItem* parentItem = m_model->root()->find(note.parentId);
-        QModelIndex parentIndex = m_model->index(parentItem);
-        m_model->insertRow(note.pos, parentIndex);
-
-        QModelIndex index = m_model->index(note.pos, 0, parentIndex);
-        m_model->setData(index, note.title, Qt::EditRole);
-        m_model->item(index)->setId(note.id);
-    }
+    // Children are fetched by the model when their parent is expanded.
+    m_model->fetchMore(QModelIndex());
 
     if (selectedId == 0) {
         setCurrentIndex(QModelIndex());
@@ -56,11 +58,26 @@ void NoteTaking::build() {
 
 void NoteTaking::clear() {
     m_isInited = false;
-    m_model.reset(new TreeModel);
+    m_selectionTimer->stop();
+    m_model.reset(new TreeModel(m_database));
     setModel(m_model.data());
-    connect(m_model.data(), &TreeModel::itemDropped, this, &NoteTaking::moveTree);
+    connect(m_model.data(), &TreeModel::itemsDropped, this, &NoteTaking::moveTrees);
 
     m_isInited = true;
+    emit treeReset();
+}
+
+void NoteTaking::saveSelectedId() {
+    m_selectionTimer->stop();
+
+    if (m_selectedId == m_savedSelectedId || !m_database->isOpen()) return;
+
+    try {
+        m_database->updateMetaValue("selected_id", m_selectedId);
+        m_savedSelectedId = m_selectedId;
+    } catch (const SqlQueryError& e) {
+        qCritical() << "Error update selected_id: " << e.error();
+    }
 }
 
 void NoteTaking::onCustomContextMenu(const QPoint& point) {
@@ -81,19 +98,21 @@ void NoteTaking::onCustomContextMenu(const QPoint& point) {
 
     auto expandAction = contextMenu->addAction(tr("Expand"), this, &NoteTaking::expandTree);
     contextMenu->addAction(tr("Collapse All"), this, &NoteTaking::collapseAll);
-    contextMenu->addAction(tr("Expand All"), this, &NoteTaking::expandAll);
+    contextMenu->addAction(tr("Expand All"), this, &NoteTaking::expandAllTrees);
 
     contextMenu->addSeparator();
 
     auto propertiesAction = contextMenu->addAction(tr("Properties..."), this, &NoteTaking::showProperties);
 
+    // Actions on one note are disabled while several notes are selected.
     bool enabled = currentIndex().isValid();
-    removeAction->setEnabled(enabled);
-    renameAction->setEnabled(enabled);
-    moveUpAction->setEnabled(enabled && currentIndex().row() > 0);
-    moveDownAction->setEnabled(enabled && currentIndex().row() < m_model->rowCount(currentIndex().parent()) - 1);
-    expandAction->setEnabled(enabled);
-    propertiesAction->setEnabled(enabled);
+    bool single = enabled && selectionModel()->selectedRows().count() <= 1;
+    removeAction->setEnabled(enabled || selectionModel()->hasSelection());
+    renameAction->setEnabled(single);
+    moveUpAction->setEnabled(single && currentIndex().row() > 0);
+    moveDownAction->setEnabled(single && currentIndex().row() < m_model->rowCount(currentIndex().parent()) - 1);
+    expandAction->setEnabled(single);
+    propertiesAction->setEnabled(single);
 
     contextMenu->exec(mapToGlobal(point));
 }
@@ -108,26 +127,30 @@ void NoteTaking::addNote() {
 }
 
 void NoteTaking::removeNotes() {
-    QModelIndex index = selectionModel()->currentIndex();
+    QVector<TreeItem*> items = m_model->topItems(selectionModel()->selectedRows());
 
-    if (QMessageBox::question(this, Application::Name,
-                              tr("Remove %1?").arg(m_model->data(index).toString())) == QMessageBox::No) return;
+    if (items.isEmpty() && currentIndex().isValid()) {
+        items.append(m_model->item(currentIndex()));
+    }
 
-    TreeItem* item = m_model->item(index);
-    Ids ids = m_model->childIds(item);
+    if (items.isEmpty()) return;
 
-    m_model->removeRow(index.row(), index.parent());
+    QString question = items.count() == 1 ? tr("Remove %1?").arg(items.first()->title())
+                                          : tr("Remove %1 notes?").arg(items.count());
 
-    TreeItem* parentItem = m_model->item(index.parent());
+    if (QMessageBox::question(this, Application::Name, question) == QMessageBox::No) return;
 
-    for (int i = 0; i < parentItem->childCount(); i++) {
-        Id id = parentItem->child(i)->id();
-        m_database->updateNoteValue(id, "pos", i);
-    }
+    Ids rootIds;
 
-    for (Id id : ids) {
-        m_database->removeNote(id);
+    for (TreeItem* item : std::as_const(items)) {
+        rootIds.append(item->id());
     }
+
+    // Children are removed by the database, they don't need to be loaded into the model.
+    Ids ids = m_database->removeSubtrees(rootIds);
+    m_model->removeItems(items);
+
+    emit notesRemoved(ids);
 }
 
 void NoteTaking::renameNote() {
@@ -136,68 +159,86 @@ void NoteTaking::renameNote() {
 
 void NoteTaking::moveUp() {
     int row = currentIndex().row();
-
-    Id id1 = m_model->item(currentIndex())->id();
-    Id id2 = m_model->item(currentIndex().sibling(row - 1, 0))->id();
+    TreeItem* item = m_model->item(currentIndex());
 
     m_model->moveRow(currentIndex().parent(), row, currentIndex().parent(), row - 1);
-
-    m_database->updateNoteValue(id1, "pos", row - 1);
-    m_database->updateNoteValue(id2, "pos", row);
+    updatePosition(item);
 }
 
 void NoteTaking::moveDown() {
     int row = currentIndex().row();
-
-    Id id1 = m_model->item(currentIndex())->id();
-    Id id2 = m_model->item(currentIndex().sibling(row + 1, 0))->id();
+    TreeItem* item = m_model->item(currentIndex());
 
     m_model->moveRow(currentIndex().parent(), row, currentIndex().parent(), row + 2);
-
-    m_database->updateNoteValue(id1, "pos", row + 1);
-    m_database->updateNoteValue(id2, "pos", row);
+    updatePosition(item);
 }
 
-void NoteTaking::moveTree(const QModelIndex& index) {
-    selectionModel()->setCurrentIndex(index, QItemSelectionModel::ClearAndSelect);
-    expand(index.parent());
+void NoteTaking::moveTrees(const QModelIndex& parent, int row, int count, const Ids& sourceParentIds) {
+    TreeItem* parentItem = m_model->item(parent);
+    Id destinationParentId = parentItem->id();
+    int depth = parentItem->depth();
 
-    // Move tree in database.
-    TreeItem* targetItem = m_model->item(index);
-    Id sourceId = targetItem->id();
-    Id sourceParentId = m_database->noteValue(sourceId, "parent_id").toInt();
-    Id destinationParentId = targetItem->parent()->id();
+    // Dropped notes share the gap between their new neighbours, siblings on both parents keep their positions.
+    TreeItem* previous = row > 0 ? parentItem->child(row - 1) : nullptr;
+    TreeItem* next = parentItem->child(row + count);
+    QVector<int> positions = TreeModel::positionsBetween(previous, next, count);
+    Ids ids;
 
-    TreeItem* sourceParentItem = m_model->root()->find(sourceParentId);
+    if (positions.isEmpty()) {
+        renumber(parentItem, ids, positions);
+    } else {
+        for (int i = 0; i < count; i++) {
+            TreeItem* item = parentItem->child(row + i);
+            item->setPos(positions.at(i));
+            ids.append(item->id());
+        }
+    }
+
+    Ids movedIds;
 
-    // Rewrite note positions on source parent.
-    for (int i = 0; i < sourceParentItem->childCount(); i++) {
-        m_database->updateNoteValue(sourceParentItem->child(i)->id(), "pos", i);
+    for (int i = 0; i < count; i++) {
+        if (sourceParentIds.at(i) != destinationParentId) {
+            movedIds.append(parentItem->child(row + i)->id());
+        }
     }
 
-    if (sourceParentId != destinationParentId) {
-        m_database->updateNoteValue(sourceId, "parent_id", destinationParentId);
+    m_database->transaction();
+
+    try {
+        m_database->updatePositions(ids, positions);
 
-         TreeItem* destinationParentItem = m_model->root()->find(destinationParentId);
+        for (Id id : std::as_const(movedIds)) {
+            m_database->updateNoteValue(id, "parent_id", destinationParentId);
+            // Rewrite depth in the moved subtree, children don't need to be loaded for that.
+            m_database->updateDepth(id, depth);
+        }
 
-         // Rewrite note positions on destination parent.
-         for (int i = 0; i < destinationParentItem->childCount(); i++) {
-             m_database->updateNoteValue(destinationParentItem->child(i)->id(), "pos", i);
-         }
+        m_database->commit();
+    } catch (...) {
+        m_database->rollback();
+        throw;
+    }
 
-         // Rewrite depth in all children of target note.
-         Ids childIds = m_model->childIds(targetItem);
-         for (Id id : childIds) {
-             int depth = targetItem->find(id)->depth() - 1;
-             m_database->updateNoteValue(id, "depth", depth);
-         }
+    for (Id id : std::as_const(movedIds)) {
+        emit noteMoved(id, destinationParentId);
     }
+
+    expand(parent);
+    selectionModel()->setCurrentIndex(m_model->index(row, 0, parent), QItemSelectionModel::ClearAndSelect);
+    selectionModel()->select(QItemSelection(m_model->index(row, 0, parent), m_model->index(row + count - 1, 0, parent)),
+                             QItemSelectionModel::Select);
 }
 
 void NoteTaking::expandTree() {
+    m_model->fetchAll(currentIndex());
     expandRecursively(currentIndex());
 }
 
+void NoteTaking::expandAllTrees() {
+    m_model->fetchAll(QModelIndex());
+    expandAll();
+}
+
 void NoteTaking::showProperties() const {
     Id id = m_model->item(currentIndex())->id();
     Note note = m_database->note(id);
@@ -208,66 +249,130 @@ void NoteTaking::showProperties() const {
 
 void NoteTaking::insertChild(const QString& title) {
     QModelIndex currentIndex = selectionModel()->currentIndex();
+    m_model->fetchMore(currentIndex);
     TreeItem* currentItem = m_model->item(currentIndex);
 
     Id currentId = currentItem->id();
-    int pos = currentItem->childCount();
+    int row = currentItem->childCount();
     int depth = currentItem->depth();
-    Id noteId = m_database->insertNote(currentId, pos, depth, title);
 
-    if (!m_model->insertRow(pos, currentIndex)) {
+    TreeItem* lastItem = row > 0 ? currentItem->child(row - 1) : nullptr;
+    std::optional<int> pos = TreeModel::positionBetween(lastItem, nullptr);
+
+    if (!pos) {
+        Ids ids;
+        QVector<int> positions;
+        renumber(currentItem, ids, positions);
+        savePositions(ids, positions);
+        pos = TreeModel::positionBetween(lastItem, nullptr);
+    }
+
+    Id noteId = m_database->insertNote(currentId, *pos, depth, title);
+
+    if (!m_model->insertRow(row, currentIndex)) {
         return;
     }
 
-    QModelIndex noteIndex = m_model->index(pos, 0, currentIndex);
+    QModelIndex noteIndex = m_model->index(row, 0, currentIndex);
     m_model->setData(noteIndex, title, Qt::EditRole);
     m_model->item(noteIndex)->setId(noteId);
+    m_model->item(noteIndex)->setPos(*pos);
+    emit noteInserted(noteId, currentId, title);
 
-    selectionModel()->setCurrentIndex(m_model->index(pos, 0, currentIndex), QItemSelectionModel::ClearAndSelect);
+    selectionModel()->setCurrentIndex(m_model->index(row, 0, currentIndex), QItemSelectionModel::ClearAndSelect);
     setExpanded(currentIndex, true);
 }
 
-int NoteTaking::exportNote(Id parentId, const QString& path) const {
-    QDir().mkpath(path);
+void NoteTaking::updatePosition(TreeItem* item) {
+    TreeItem* parentItem = item->parent();
+    int row = item->childNumber();
+    TreeItem* previous = row > 0 ? parentItem->child(row - 1) : nullptr;
+    TreeItem* next = row + 1 < parentItem->childCount() ? parentItem->child(row + 1) : nullptr;
+
+    if (std::optional<int> pos = TreeModel::positionBetween(previous, next)) {
+        item->setPos(*pos);
+        m_database->updateNoteValue(item->id(), "pos", *pos);
+    } else {
+        Ids ids;
+        QVector<int> positions;
+        renumber(parentItem, ids, positions);
+        savePositions(ids, positions);
+    }
+}
 
-    int count = 0;
-    TreeItem* parentItem = m_model->root()->find(parentId);
+void NoteTaking::renumber(TreeItem* parentItem, Ids& ids, QVector<int>& positions) {
+    ids.clear();
+    positions.clear();
 
     for (int i = 0; i < parentItem->childCount(); i++) {
-        TreeItem* childItem = parentItem->child(i);
-        QString title = childItem->data().toString();
-        QString note = m_database->noteValue(childItem->id(), "note").toString();
-        QString notePath = path + "/" + title;
-
-        QString filename = notePath + ".txt";
-        QFile file(filename);
-
-        if (file.open(QIODevice::ReadWrite)) {
-            QTextStream stream(&file);
-            stream << note;
-            file.close();
-        }
+        TreeItem* item = parentItem->child(i);
+        item->setPos((i + 1) * Database::PositionGap);
 
-        count++;
+        ids.append(item->id());
+        positions.append(item->pos());
+    }
+}
 
-        if (childItem->childCount()) {
-            count += exportNote(childItem->id(), notePath);
-        }
+void NoteTaking::savePositions(const Ids& ids, const QVector<int>& positions) {
+    m_database->transaction();
+
+    try {
+        m_database->updatePositions(ids, positions);
+        m_database->commit();
+    } catch (...) {
+        m_database->rollback();
+        throw;
     }
+}
 
-    return count;
+Id NoteTaking::currentId() const {
+    return m_model->item(currentIndex())->id();
+}
+
+Ids NoteTaking::selectedIds() const {
+    Ids result;
+
+    for (TreeItem* item : m_model->topItems(selectionModel()->selectedRows())) {
+        result.append(item->id());
+    }
+
+    return result;
 }
 
 void NoteTaking::setCurrentId(Id id) {
-    TreeItem* item = m_model->root()->find(id);
-    QModelIndex index = m_model->index(item);
+    QModelIndex index = m_model->reveal(id);
     setCurrentIndex(index);
 
-    TreeItem* parent = item->parent();
+    for (QModelIndex parent = index.parent(); parent.isValid(); parent = parent.parent()) {
+        setExpanded(parent, true);
+    }
+}
+
+void NoteTaking::updateTitles(const QVector<Note>& notes) {
+    QHash<Id, QString> titles;
+
+    for (const Note& note : notes) {
+        titles[note.id] = note.title;
+    }
+
+    // Only fetched items are shown, the rest get new titles from the database when expanded.
+    QVector<TreeItem*> stack = { m_model->root() };
+
+    while (!stack.isEmpty()) {
+        TreeItem* item = stack.takeLast();
+        auto it = titles.constFind(item->id());
+
+        if (it != titles.cend() && item->title() != it.value()) {
+            m_model->setData(m_model->index(item), it.value());
+        }
+
+        for (int i = 0; i < item->childCount(); i++) {
+            stack.append(item->child(i));
+        }
+    }
 
-    while (parent != m_model->root()) {
-        setExpanded(m_model->index(parent), true);
-        parent = parent->parent();
+    for (const Note& note : notes) {
+        emit noteRenamed(note.id, note.title);
     }
 }
 
@@ -283,11 +388,11 @@ void NoteTaking::mousePressEvent(QMouseEvent* event) {
 void NoteTaking::currentChanged(const QModelIndex& current, const QModelIndex& previous [[maybe_unused]]) {
     if (!m_isInited) return;
 
-    try {
-        Id id = m_model->item(current)->id();
-        m_database->updateMetaValue("selected_id", id);
-        emit noteChanged(id);
-    } catch (const SqlQueryError& e) {
-        qCritical() << "Error update selected_id: " << e.error();
+    m_selectedId = m_model->item(current)->id();
+
+    if (m_selectedId != m_savedSelectedId) {
+        m_selectionTimer->start();
     }
+
+    emit noteChanged(m_selectedId);
 }
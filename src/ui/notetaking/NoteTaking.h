@@ -1,10 +1,12 @@
 #pragma once
 #include <QTreeView>
-#include "core/Globals.h"
+#include "core/Model.h"
 
 class QMenu;
 class QAction;
+class QTimer;
 class TreeModel;
+class TreeItem;
 class Database;
 
 class NoteTaking : public QTreeView {
@@ -12,15 +14,23 @@ class NoteTaking : public QTreeView {
 public:
     NoteTaking(Database* database);
 
-    int exportNote(Id parentId, const QString& path) const;
+    Id currentId() const;
     void setCurrentId(Id id);
+    Ids selectedIds() const;
+    void updateTitles(const QVector<Note>& notes);
 
 public slots:
     void build();
     void clear();
+    void saveSelectedId();
 
 signals:
     void noteChanged(Id id);
+    void treeReset();
+    void noteInserted(Id id, Id parentId, const QString& title);
+    void noteRenamed(Id id, const QString& title);
+    void noteMoved(Id id, Id parentId);
+    void notesRemoved(const Ids& ids);
 
 protected:
     void mousePressEvent(QMouseEvent* event) override;
@@ -35,14 +45,23 @@ private slots:
     void renameNote();
     void moveUp();
     void moveDown();
-    void moveTree(const QModelIndex& index);
+    void moveTrees(const QModelIndex& parent, int row, int count, const Ids& sourceParentIds);
     void expandTree();
+    void expandAllTrees();
     void showProperties() const;
 
 private:
     void insertChild(const QString& title);
+    void updatePosition(TreeItem* item);
+    void renumber(TreeItem* parentItem, Ids& ids, QVector<int>& positions);
+    void savePositions(const Ids& ids, const QVector<int>& positions);
 
     QScopedPointer<TreeModel> m_model;
     Database* m_database = nullptr;
     bool m_isInited = false;
+
+    // Selection is written to the database once navigation pauses, not on every row.
+    QTimer* m_selectionTimer = nullptr;
+    Id m_selectedId = 0;
+    Id m_savedSelectedId = 0;
 };
@@ -0,0 +1,172 @@
+#include "TitleIndex.h"
+#include <QSet>
+
+constexpr auto TrigramSize = 3;
+
+void TitleIndex::clear() {
+    m_entries.clear();
+    m_slots.clear();
+    m_trigrams.clear();
+    m_lastKey.clear();
+    m_lastMatches.clear();
+}
+
+void TitleIndex::insert(Id id, Id parentId, const QString& title) {
+    if (m_slots.contains(id)) {
+        rename(id, title);
+        move(id, parentId);
+        return;
+    }
+
+    Entry entry;
+    entry.id = id;
+    entry.parentId = parentId;
+    entry.title = title;
+    entry.key = title.toCaseFolded();
+
+    int slot = m_entries.count();
+    m_entries.append(entry);
+    m_slots[id] = slot;
+
+    addTrigrams(slot, m_entries.at(slot).key);
+    m_lastKey.clear();
+}
+
+void TitleIndex::rename(Id id, const QString& title) {
+    int slot = m_slots.value(id, -1);
+    if (slot < 0) return;
+
+    // Postings of the old title are left in place, match() verifies every candidate.
+    Entry& entry = m_entries[slot];
+    QString oldKey = entry.key;
+    entry.title = title;
+    entry.key = title.toCaseFolded();
+
+    addTrigrams(slot, entry.key, oldKey);
+    m_lastKey.clear();
+}
+
+void TitleIndex::move(Id id, Id parentId) {
+    int slot = m_slots.value(id, -1);
+    if (slot < 0) return;
+
+    m_entries[slot].parentId = parentId;
+}
+
+void TitleIndex::remove(Id id) {
+    int slot = m_slots.value(id, -1);
+    if (slot < 0) return;
+
+    m_entries[slot] = Entry();
+    m_slots.remove(id);
+    m_lastKey.clear();
+}
+
+int TitleIndex::slot(Id id) const {
+    return m_slots.value(id, -1);
+}
+
+const TitleIndex::Entry& TitleIndex::entry(int slot) const {
+    return m_entries.at(slot);
+}
+
+int TitleIndex::count() const {
+    return m_slots.count();
+}
+
+QVector<int> TitleIndex::match(const QString& text) {
+    QString key = text.toCaseFolded();
+    QVector<int> result;
+
+    if (key.isEmpty()) {
+        m_lastKey.clear();
+        return result;
+    }
+
+    if (!m_lastKey.isEmpty() && key.contains(m_lastKey)) {
+        for (int slot : std::as_const(m_lastMatches)) {
+            if (m_entries.at(slot).key.contains(key)) {
+                result.append(slot);
+            }
+        }
+    } else if (key.size() < TrigramSize) {
+        for (int slot = 0; slot < m_entries.count(); slot++) {
+            if (m_entries.at(slot).key.contains(key)) {
+                result.append(slot);
+            }
+        }
+    } else {
+        // Verify candidates from the rarest trigram of the text.
+        const QVector<int>* candidates = nullptr;
+
+        for (int i = 0; i + TrigramSize <= key.size(); i++) {
+            auto it = m_trigrams.constFind(trigram(key.constData() + i));
+
+            if (it == m_trigrams.cend()) {
+                candidates = nullptr;
+                break;
+            }
+
+            if (!candidates || it->count() < candidates->count()) {
+                candidates = &it.value();
+            }
+        }
+
+        if (candidates) {
+            for (int slot : *candidates) {
+                if (m_entries.at(slot).key.contains(key)) {
+                    result.append(slot);
+                }
+            }
+
+            std::sort(result.begin(), result.end());
+            result.erase(std::unique(result.begin(), result.end()), result.end());
+        }
+    }
+
+    m_lastKey = key;
+    m_lastMatches = result;
+
+    return result;
+}
+
+QVector<int> TitleIndex::visibleSlots(const QVector<int>& matches) const {
+    QVector<int> result;
+    QVector<bool> marked(m_entries.count());
+
+    for (int slot : matches) {
+        // Stop at the first ancestor already marked by another match.
+        while (slot >= 0 && !marked.at(slot)) {
+            marked[slot] = true;
+            result.append(slot);
+            slot = m_slots.value(m_entries.at(slot).parentId, -1);
+        }
+    }
+
+    std::sort(result.begin(), result.end());
+
+    return result;
+}
+
+void TitleIndex::addTrigrams(int slot, const QString& key, const QString& oldKey) {
+    QSet<quint64> oldTrigrams;
+
+    for (int i = 0; i + TrigramSize <= oldKey.size(); i++) {
+        oldTrigrams.insert(trigram(oldKey.constData() + i));
+    }
+
+    QSet<quint64> added;
+
+    for (int i = 0; i + TrigramSize <= key.size(); i++) {
+        quint64 value = trigram(key.constData() + i);
+
+        if (!oldTrigrams.contains(value) && !added.contains(value)) {
+            m_trigrams[value].append(slot);
+            added.insert(value);
+        }
+    }
+}
+
+quint64 TitleIndex::trigram(const QChar* data) {
+    return quint64(data[0].unicode()) << 32 | quint64(data[1].unicode()) << 16 | data[2].unicode();
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "core/Globals.h"
+#include <QHash>
+#include <QString>
+
+class TitleIndex {
+public:
+    struct Entry {
+        Id id = 0;
+        Id parentId = 0;
+        QString title;
+        QString key;
+    };
+
+    void clear();
+
+    void insert(Id id, Id parentId, const QString& title);
+    void rename(Id id, const QString& title);
+    void move(Id id, Id parentId);
+    void remove(Id id);
+
+    int slot(Id id) const;
+    const Entry& entry(int slot) const;
+    int count() const;
+
+    // Slots of entries whose title contains text, refined from the previous result while typing.
+    QVector<int> match(const QString& text);
+    // Matched slots with all their ancestors, sorted by slot.
+    QVector<int> visibleSlots(const QVector<int>& matches) const;
+
+private:
+    void addTrigrams(int slot, const QString& key, const QString& oldKey = QString());
+    static quint64 trigram(const QChar* data);
+
+    QVector<Entry> m_entries;
+    QHash<Id, int> m_slots;
+    QHash<quint64, QVector<int>> m_trigrams;
+
+    QString m_lastKey;
+    QVector<int> m_lastMatches;
+};
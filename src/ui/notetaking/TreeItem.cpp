@@ -1,13 +1,4 @@
 #include "TreeItem.h"
-#include <QStringList>
-#include <QModelIndex>
-
-TreeItem::TreeItem(TreeItem* parent) : m_parent(parent) {
-}
-
-TreeItem::~TreeItem() {
-    qDeleteAll(m_children);
-}
 
 TreeItem* TreeItem::child(int number) const {
     return m_children.value(number);
@@ -19,14 +10,15 @@ int TreeItem::childCount() const {
 
 int TreeItem::childNumber() const {
     if (m_parent) {
-        return m_parent->m_children.indexOf(const_cast<TreeItem*>(this));
+        m_parent->updateRows();
+        return m_row;
     }
 
     return 0;
 }
 
-QVariant TreeItem::data() const {
-    return m_data;
+QString TreeItem::title() const {
+    return m_title;
 }
 
 TreeItem* TreeItem::parent() {
@@ -40,7 +32,7 @@ void TreeItem::setParent(TreeItem* parent) {
 TreeItem* TreeItem::find(Id id) {
     if (m_id == id) return this;
 
-    for (TreeItem* child : m_children) {
+    for (TreeItem* child : std::as_const(m_children)) {
         TreeItem* item = child->find(id);
 
         if (item) {
@@ -52,24 +44,31 @@ TreeItem* TreeItem::find(Id id) {
 }
 
 bool TreeItem::insertChild(int position, TreeItem* item) {
-    TreeItem* childItem = item ? item : new TreeItem;
-    childItem->setParent(this);
-    m_children.insert(position, childItem);
+    if (!item || position < 0 || position > m_children.count()) return false;
+
+    item->setParent(this);
+    item->m_row = position;
+    m_children.insert(position, item);
+
+    if (position < m_children.count() - 1) {
+        m_dirtyRow = std::min(m_dirtyRow, position + 1);
+    }
 
     return true;
 }
 
-bool TreeItem::removeChild(int position) {
-    if (position < 0 || position > m_children.count() - 1) return false;
+TreeItem* TreeItem::takeChild(int position) {
+    if (position < 0 || position > m_children.count() - 1) return nullptr;
 
-    delete m_children.at(position);
-    m_children.removeAt(position);
+    TreeItem* result = m_children.takeAt(position);
+    result->setParent(nullptr);
+    m_dirtyRow = std::min(m_dirtyRow, position);
 
-    return true;
+    return result;
 }
 
-void TreeItem::setData(const QVariant& data) {
-    m_data = data;
+void TreeItem::setTitle(const QString& title) {
+    m_title = title;
 }
 
 Id TreeItem::id() const {
@@ -80,6 +79,22 @@ void TreeItem::setId(Id id) {
     m_id = id;
 }
 
+int TreeItem::pos() const {
+    return m_pos;
+}
+
+void TreeItem::setPos(int pos) {
+    m_pos = pos;
+}
+
+bool TreeItem::isFetched() const {
+    return m_fetched;
+}
+
+void TreeItem::setFetched(bool fetched) {
+    m_fetched = fetched;
+}
+
 int TreeItem::depth() {
     int counter = 0;
     TreeItem* item = this;
@@ -91,3 +106,22 @@ int TreeItem::depth() {
 
     return counter;
 }
+
+void TreeItem::reset() {
+    m_children.clear();
+    m_title.clear();
+    m_parent = nullptr;
+    m_id = 0;
+    m_pos = 0;
+    m_fetched = true;
+    m_row = 0;
+    m_dirtyRow = std::numeric_limits<int>::max();
+}
+
+void TreeItem::updateRows() const {
+    for (int i = m_dirtyRow; i < m_children.count(); i++) {
+        m_children.at(i)->m_row = i;
+    }
+
+    m_dirtyRow = std::numeric_limits<int>::max();
+}
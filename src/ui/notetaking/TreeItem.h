@@ -1,12 +1,12 @@
 #pragma once
 #include "core/Globals.h"
 #include <QList>
-#include <QVariant>
+#include <QString>
+#include <limits>
 
 class TreeItem {
 public:
-    explicit TreeItem(TreeItem* parent = nullptr);
-    ~TreeItem();
+    TreeItem() = default;
 
     TreeItem* parent();
     void setParent(TreeItem* parent);
@@ -17,20 +17,36 @@ public:
     int childCount() const;
     int childNumber() const;
 
-    QVariant data() const;
-    void setData(const QVariant& data);
+    QString title() const;
+    void setTitle(const QString& title);
 
-    bool insertChild(int position, TreeItem* item = nullptr);
-    bool removeChild(int position);
+    bool insertChild(int position, TreeItem* item);
+    TreeItem* takeChild(int position);
 
     Id id() const;
     void setId(Id id);
 
+    int pos() const;
+    void setPos(int pos);
+
+    bool isFetched() const;
+    void setFetched(bool fetched);
+
     int depth();
 
+    void reset();
+
 private:
+    void updateRows() const;
+
     QList<TreeItem*> m_children;
-    QVariant m_data;
+    QString m_title;
     TreeItem* m_parent = nullptr;
     Id m_id = 0;
+    int m_pos = 0;
+    bool m_fetched = true;
+
+    // Row in parent is cached, rows of children starting from m_dirtyRow are renumbered on demand.
+    mutable int m_row = 0;
+    mutable int m_dirtyRow = std::numeric_limits<int>::max();
 };
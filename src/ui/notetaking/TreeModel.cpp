@@ -1,12 +1,18 @@
 #include "TreeModel.h"
 #include "TreeItem.h"
+#include "database/Database.h"
+#include "database/DatabaseException.h"
 #include <QMimeData>
 #include <QIODevice>
+#include <QSet>
+#include <limits>
+#include <functional>
 
 constexpr auto TreeItemMimeType = "application/x-treeitem";
 
-TreeModel::TreeModel(QObject* parent) : QAbstractItemModel (parent) {
-    m_rootItem.reset(new TreeItem);
+TreeModel::TreeModel(Database* database, QObject* parent) : QAbstractItemModel (parent), m_database(database) {
+    m_rootItem = createItem();
+    m_rootItem->setFetched(!database);
 }
 
 TreeModel::~TreeModel() {
@@ -24,7 +30,7 @@ QModelIndex TreeModel::parent(const QModelIndex& child) const {
 
     TreeItem* parentItem = item(child)->parent();
 
-    if (item(child)->parent() == m_rootItem.data()) {
+    if (item(child)->parent() == m_rootItem) {
         return QModelIndex();
     }
 
@@ -48,7 +54,7 @@ QVariant TreeModel::data(const QModelIndex& index, int role) const {
         return QVariant();
     }
 
-    return item(index)->data();
+    return item(index)->title();
 }
 
 Qt::ItemFlags TreeModel::flags(const QModelIndex& index) const {
@@ -64,13 +70,55 @@ bool TreeModel::setData(const QModelIndex& index, const QVariant& value, int rol
         return false;
     }
 
-    item(index)->setData(value);
+    item(index)->setTitle(value.toString());
 
     emit dataChanged(index, index);
 
     return true;
 }
 
+bool TreeModel::hasChildren(const QModelIndex& parent) const {
+    TreeItem* parentItem = item(parent);
+    return parentItem->childCount() || !parentItem->isFetched();
+}
+
+bool TreeModel::canFetchMore(const QModelIndex& parent) const {
+    return m_database && m_database->isOpen() && !item(parent)->isFetched();
+}
+
+void TreeModel::fetchMore(const QModelIndex& parent) {
+    if (!canFetchMore(parent)) return;
+
+    TreeItem* parentItem = item(parent);
+    parentItem->setFetched(true);
+
+    QVector<ChildNote> notes;
+
+    try {
+        notes = m_database->childNotes(parentItem->id());
+    } catch (const SqlQueryError& e) {
+        qCritical() << "Error fetch notes: " << e.error();
+        return;
+    }
+
+    if (notes.isEmpty()) return;
+
+    int first = parentItem->childCount();
+    beginInsertRows(parent, first, first + notes.count() - 1);
+
+    for (const ChildNote& note : notes) {
+        TreeItem* childItem = createItem();
+        childItem->setId(note.id);
+        childItem->setPos(note.pos);
+        childItem->setTitle(note.title);
+        childItem->setFetched(!note.hasChildren);
+
+        parentItem->insertChild(parentItem->childCount(), childItem);
+    }
+
+    endInsertRows();
+}
+
 Qt::DropActions TreeModel::supportedDropActions() const {
     return Qt::MoveAction;
 }
@@ -87,7 +135,12 @@ QMimeData* TreeModel::mimeData(const QModelIndexList& indexes) const {
     auto result = new QMimeData;
     QByteArray data;
     QDataStream stream(&data, QIODevice::WriteOnly);
-    stream << item(indexes.first())->id();
+
+    // Selected descendants move with their selected ancestors.
+    for (TreeItem* topItem : topItems(indexes)) {
+        stream << topItem->id();
+    }
+
     result->setData(TreeItemMimeType, data);
     return result;
 }
@@ -102,79 +155,152 @@ bool TreeModel::canDropMimeData(const QMimeData* mimeData, Qt::DropAction action
 bool TreeModel::dropMimeData(const QMimeData* mimeData, Qt::DropAction action, int row, int column [[maybe_unused]], const QModelIndex& parent) {
     if (!canDropMimeData(mimeData, action, row, column, parent)) return false;
 
+    // Load children of target first, otherwise the dropped items would be fetched again from database.
+    fetchMore(parent);
+
     QByteArray data = mimeData->data(TreeItemMimeType);
     QDataStream stream(&data, QIODevice::ReadOnly);
-    Id id;
-    stream >> id;
-
-    TreeItem* sourceItem = m_rootItem->find(id);
-    QModelIndex sourceParent = index(sourceItem->parent());
-
-    if (row < 0) {
-        if (parent.isValid()) {
-            row = 0;
-        } else if (sourceItem->parent() == m_rootItem.data()) {
-            row = rowCount(parent) - 1;
-        } else {
-            row = rowCount(parent);
+    Ids ids;
+
+    while (!stream.atEnd()) {
+        Id id;
+        stream >> id;
+        ids.append(id);
+    }
+
+    // Dragged items are looked up in one walk over the loaded tree.
+    QHash<Id, TreeItem*> items;
+    QVector<TreeItem*> stack = { m_rootItem };
+
+    for (Id id : std::as_const(ids)) {
+        items[id] = nullptr;
+    }
+
+    while (!stack.isEmpty()) {
+        TreeItem* currentItem = stack.takeLast();
+        auto it = items.find(currentItem->id());
+
+        if (it != items.end() && currentItem != m_rootItem) {
+            it.value() = currentItem;
+        }
+
+        for (int i = 0; i < currentItem->childCount(); i++) {
+            stack.append(currentItem->child(i));
         }
-    } else if (sourceItem->parent() == item(parent) && sourceItem->childNumber() < row) {
-        row--;
     }
 
-    removeRow(sourceItem->childNumber(), sourceParent);
+    TreeItem* parentItem = item(parent);
+    QVector<TreeItem*> sourceItems;
 
-    beginInsertRows(parent, row, row);
-    item(parent)->insertChild(row, sourceItem);
-    endInsertRows();
+    for (Id id : std::as_const(ids)) {
+        if (TreeItem* sourceItem = items.value(id)) {
+            sourceItems.append(sourceItem);
+        }
+    }
+
+    // Note can't be moved into its own subtree.
+    for (TreeItem* ancestor = parentItem; ancestor; ancestor = ancestor->parent()) {
+        if (sourceItems.contains(ancestor)) return false;
+    }
 
-    emit itemDropped(index(row, 0, parent));
+    if (sourceItems.isEmpty()) return false;
+
+    // Dropped items are moved before this sibling, which is not one of them.
+    TreeItem* nextItem = nullptr;
+
+    if (row >= 0) {
+        nextItem = parentItem->child(row);
+    } else if (parent.isValid()) {
+        nextItem = parentItem->child(0);
+    }
+
+    while (nextItem && sourceItems.contains(nextItem)) {
+        nextItem = parentItem->child(nextItem->childNumber() + 1);
+    }
+
+    Ids sourceParentIds;
+
+    // Moved rather than removed and inserted, so persistent indexes of the subtrees and their expanded state are kept.
+    for (TreeItem* sourceItem : std::as_const(sourceItems)) {
+        TreeItem* sourceParentItem = sourceItem->parent();
+        sourceParentIds.append(sourceParentItem->id());
+
+        int sourceRow = sourceItem->childNumber();
+        int destinationRow = nextItem ? nextItem->childNumber() : parentItem->childCount();
+
+        // Item that already stands before the next one is not moved.
+        if (!beginMoveRows(index(sourceParentItem), sourceRow, sourceRow, index(parentItem), destinationRow)) continue;
+
+        sourceParentItem->takeChild(sourceRow);
+
+        if (sourceParentItem == parentItem && destinationRow > sourceRow) {
+            destinationRow--;
+        }
+
+        parentItem->insertChild(destinationRow, sourceItem);
+        endMoveRows();
+    }
+
+    // Index of the parent is stale when its preceding siblings were moved.
+    QModelIndex parentIndex = index(parentItem);
+    row = sourceItems.constFirst()->childNumber();
+
+    emit itemsDropped(parentIndex, row, sourceItems.count(), sourceParentIds);
 
     return false; // Need false to disable removing row by Qt.
 }
 
 bool TreeModel::insertRows(int position, int rows [[maybe_unused]], const QModelIndex& parent) {
     beginInsertRows(parent, position, position);
-    bool success = item(parent)->insertChild(position);
+    TreeItem* newItem = createItem();
+    bool success = item(parent)->insertChild(position, newItem);
+
+    if (!success) {
+        releaseItem(newItem);
+    }
+
     endInsertRows();
 
     return success;
 }
 
-bool TreeModel::removeRows(int position, int rows [[maybe_unused]], const QModelIndex& parent) {
-    beginRemoveRows(parent, position, position);
-    bool success = item(parent)->removeChild(position);
+bool TreeModel::removeRows(int position, int rows, const QModelIndex& parent) {
+    TreeItem* parentItem = item(parent);
+
+    if (position < 0 || rows <= 0 || position + rows > parentItem->childCount()) return false;
+
+    beginRemoveRows(parent, position, position + rows - 1);
+
+    // Taken from the end, so that rows before the range don't need renumbering.
+    for (int i = position + rows - 1; i >= position; i--) {
+        releaseItem(parentItem->takeChild(i));
+    }
+
     endRemoveRows();
 
-    return success;
+    return true;
 }
 
 bool TreeModel::moveRows(const QModelIndex& sourceParent, int sourceRow, int count [[maybe_unused]], const QModelIndex& destinationParent, int destinationChild) {
-    bool success = false;
-
-    beginMoveRows(sourceParent, sourceRow, sourceRow, destinationParent, destinationChild);
-    TreeItem* sourceParentItem = item(sourceParent);
-    TreeItem* targetItem = sourceParentItem->child(sourceRow);
+    if (!beginMoveRows(sourceParent, sourceRow, sourceRow, destinationParent, destinationChild)) {
+        return false;
+    }
 
-    success = item(destinationParent)->insertChild(destinationChild, targetItem);
+    TreeItem* targetItem = item(sourceParent)->takeChild(sourceRow);
 
-    if (success) {
-        if (sourceParent == destinationParent) {
-            if (sourceRow > destinationChild) {
-                success = sourceParentItem->removeChild(sourceRow + 1);
-            } else {
-                success = sourceParentItem->removeChild(sourceRow);
-            }
-        }
+    if (sourceParent == destinationParent && destinationChild > sourceRow) {
+        destinationChild--;
     }
 
+    bool success = item(destinationParent)->insertChild(destinationChild, targetItem);
+
     endMoveRows();
 
     return success;
 }
 
 TreeItem* TreeModel::root() const {
-    return m_rootItem.data();
+    return m_rootItem;
 }
 
 TreeItem* TreeModel::item(const QModelIndex& index) const {
@@ -186,19 +312,181 @@ TreeItem* TreeModel::item(const QModelIndex& index) const {
         }
     }
 
-    return m_rootItem.data();
+    return m_rootItem;
 }
 
 QModelIndex TreeModel::index(TreeItem* item) const {
-    return item ? createIndex(item->childNumber(), 0, item) : QModelIndex();
+    return item && item != m_rootItem ? createIndex(item->childNumber(), 0, item) : QModelIndex();
 }
 
 Ids TreeModel::childIds(TreeItem* item) const {
     Ids result;
-    result.append(item->id());
+    QVector<TreeItem*> stack = { item };
+
+    while (!stack.isEmpty()) {
+        TreeItem* currentItem = stack.takeLast();
+        result.append(currentItem->id());
+
+        for (int i = currentItem->childCount() - 1; i >= 0; i--) {
+            stack.append(currentItem->child(i));
+        }
+    }
+
+    return result;
+}
+
+QVector<TreeItem*> TreeModel::topItems(const QModelIndexList& indexes) const {
+    QSet<TreeItem*> selectedItems;
+
+    for (const QModelIndex& index : indexes) {
+        if (index.isValid()) {
+            selectedItems.insert(item(index));
+        }
+    }
+
+    QVector<std::pair<QVector<int>, TreeItem*>> result;
+
+    for (TreeItem* selectedItem : std::as_const(selectedItems)) {
+        QVector<int> rows = { selectedItem->childNumber() };
+        bool top = true;
+
+        for (TreeItem* ancestor = selectedItem->parent(); ancestor != m_rootItem; ancestor = ancestor->parent()) {
+            if (selectedItems.contains(ancestor)) {
+                top = false;
+                break;
+            }
+
+            rows.prepend(ancestor->childNumber());
+        }
+
+        if (top) {
+            result.append({ rows, selectedItem });
+        }
+    }
+
+    // Paths of rows from the root give the order in the tree.
+    std::sort(result.begin(), result.end(), [] (const auto& a, const auto& b) {
+        return a.first < b.first;
+    });
+
+    QVector<TreeItem*> items;
+
+    for (const auto& [rows, topItem] : std::as_const(result)) {
+        items.append(topItem);
+    }
+
+    return items;
+}
+
+void TreeModel::removeItems(const QVector<TreeItem*>& items) {
+    QHash<TreeItem*, QVector<int>> parentRows;
+
+    for (TreeItem* removedItem : items) {
+        parentRows[removedItem->parent()].append(removedItem->childNumber());
+    }
+
+    // Adjacent rows are removed as one range, starting from the last so that earlier rows keep their numbers.
+    for (auto it = parentRows.begin(); it != parentRows.end(); it++) {
+        QVector<int>& rows = it.value();
+        std::sort(rows.begin(), rows.end(), std::greater<int>());
+        QModelIndex parentIndex = index(it.key());
+
+        for (int i = 0; i < rows.count();) {
+            int last = rows.at(i);
+            int first = last;
+
+            while (++i < rows.count() && rows.at(i) == first - 1) {
+                first--;
+            }
+
+            removeRows(first, last - first + 1, parentIndex);
+        }
+    }
+}
+
+void TreeModel::fetchAll(const QModelIndex& parent) {
+    fetchMore(parent);
+
+    for (int i = 0; i < rowCount(parent); i++) {
+        fetchAll(index(i, 0, parent));
+    }
+}
+
+QModelIndex TreeModel::reveal(Id id) {
+    if (!m_database) {
+        return index(m_rootItem->find(id));
+    }
+
+    Ids path = m_database->parentIds(id);
+    path.append(id);
+
+    TreeItem* currentItem = m_rootItem;
+
+    for (Id pathId : std::as_const(path)) {
+        fetchMore(index(currentItem));
+        TreeItem* nextItem = nullptr;
+
+        for (int i = 0; i < currentItem->childCount(); i++) {
+            if (currentItem->child(i)->id() == pathId) {
+                nextItem = currentItem->child(i);
+                break;
+            }
+        }
+
+        if (!nextItem) {
+            return QModelIndex();
+        }
+
+        currentItem = nextItem;
+    }
+
+    return index(currentItem);
+}
+
+TreeItem* TreeModel::createItem() {
+    if (!m_freeItems.isEmpty()) {
+        return m_freeItems.takeLast();
+    }
+
+    return &m_items.emplace_back();
+}
+
+void TreeModel::releaseItem(TreeItem* item) {
+    // Free list doubles as the queue of the subtree, so deep trees are released in one pass without recursion.
+    qsizetype first = m_freeItems.size();
+    m_freeItems.append(item);
+
+    for (qsizetype i = first; i < m_freeItems.size(); i++) {
+        TreeItem* currentItem = m_freeItems.at(i);
+
+        for (int j = 0; j < currentItem->childCount(); j++) {
+            m_freeItems.append(currentItem->child(j));
+        }
+
+        currentItem->reset();
+    }
+}
+
+std::optional<int> TreeModel::positionBetween(const TreeItem* previous, const TreeItem* next) {
+    QVector<int> positions = positionsBetween(previous, next, 1);
+    return positions.isEmpty() ? std::nullopt : std::optional<int>(positions.first());
+}
+
+QVector<int> TreeModel::positionsBetween(const TreeItem* previous, const TreeItem* next, int count) {
+    qint64 span = qint64(count + 1) * Database::PositionGap;
+    qint64 lower = previous ? previous->pos() : (next ? next->pos() - span : 0);
+    qint64 upper = next ? next->pos() : lower + span;
+    qint64 step = (upper - lower) / (count + 1);
+
+    // No free positions between the siblings, they have to be renumbered.
+    if (step < 1 || lower < std::numeric_limits<int>::min() || upper > std::numeric_limits<int>::max()) {
+        return {};
+    }
+
+    QVector<int> result;
 
-    for (int i = 0; i < item->childCount(); i++) {
-        result.append(childIds(item->child(i)));
+    for (int i = 1; i <= count; i++) {
+        result.append(int(lower + step * i));
     }
 
     return result;
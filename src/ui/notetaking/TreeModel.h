@@ -1,13 +1,16 @@
 #pragma once
 #include "core/Globals.h"
 #include <QAbstractItemModel>
+#include <deque>
+#include <optional>
 
 class TreeItem;
+class Database;
 
 class TreeModel : public QAbstractItemModel {
     Q_OBJECT
 public:
-    TreeModel(QObject* parent = nullptr);
+    TreeModel(Database* database = nullptr, QObject* parent = nullptr);
     ~TreeModel() override;
 
     QModelIndex index(int row, int column, const QModelIndex& parent) const override;
@@ -18,6 +21,10 @@ public:
     Qt::ItemFlags flags(const QModelIndex& index) const override;
     bool setData(const QModelIndex& index, const QVariant& value, int role = Qt::EditRole) override;
 
+    bool hasChildren(const QModelIndex& parent = QModelIndex()) const override;
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
+
     Qt::DropActions supportedDropActions() const override;
     Qt::DropActions supportedDragActions() const override;
     QStringList mimeTypes() const override;
@@ -33,10 +40,26 @@ public:
     TreeItem* item(const QModelIndex& index) const;
     QModelIndex index(TreeItem* item) const;
     Ids childIds(TreeItem* item) const;
+    QVector<TreeItem*> topItems(const QModelIndexList& indexes) const;
+    void removeItems(const QVector<TreeItem*>& items);
+
+    void fetchAll(const QModelIndex& parent);
+    QModelIndex reveal(Id id);
+
+    static std::optional<int> positionBetween(const TreeItem* previous, const TreeItem* next);
+    static QVector<int> positionsBetween(const TreeItem* previous, const TreeItem* next, int count);
 
 signals:
-    void itemDropped(const QModelIndex& index);
+    void itemsDropped(const QModelIndex& parent, int row, int count, const Ids& sourceParentIds);
 
 private:
-    QScopedPointer<TreeItem> m_rootItem;
+    TreeItem* createItem();
+    void releaseItem(TreeItem* item);
+
+    Database* m_database = nullptr;
+
+    // Items are kept in chunks of contiguous storage, released ones are reused.
+    std::deque<TreeItem> m_items;
+    QVector<TreeItem*> m_freeItems;
+    TreeItem* m_rootItem = nullptr;
 };
@@ -0,0 +1,615 @@
+#include <database/Database.h>
+#include <database/Search.h>
+#include <database/RecoveryJournal.h>
+#include <QSqlQuery>
+#include <QTest>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QFileInfo>
+
+constexpr auto NoteSize = 4 * 1024 * 1024;
+
+class TestDatabase : public QObject {
+    Q_OBJECT
+private slots:
+    void init();
+    void cleanup();
+
+    void compressNote();
+    void compressionSize_data();
+    void compressionSize();
+
+    void queryPlan_data();
+    void queryPlan();
+
+    void updateDepth();
+    void removeSubtrees();
+    void editorState();
+    void switchNotes_data();
+    void switchNotes();
+    void revisions();
+    void revisionKeyframes();
+    void pruneRevisions();
+    void recoveryJournal();
+
+    void search();
+    void searchOptions_data();
+    void searchOptions();
+    void replace();
+    void replaceMany();
+
+private:
+    QVector<FindNote> search(const Search::Options& options);
+    QString largeNote() const;
+    QString queryPlan(const QString& sql, const QVariantMap& params) const;
+
+    QTemporaryDir m_dir;
+    QString m_filePath;
+    QScopedPointer<Database> m_database;
+};
+
+void TestDatabase::init() {
+    m_filePath = m_dir.filePath(QString("%1.db").arg(QTest::currentTestFunction()));
+    QFile::remove(m_filePath);
+
+    m_database.reset(new Database);
+    m_database->create(m_filePath);
+    m_database->open(m_filePath);
+}
+
+void TestDatabase::cleanup() {
+    m_database.reset();
+}
+
+void TestDatabase::compressNote() {
+    QString note = largeNote();
+    Id id = m_database->insertNote(0, 0, 0, "Log");
+    m_database->updateNoteValue(id, "note", note);
+
+    QCOMPARE(m_database->noteValue(id, "compressed").toInt(), 1);
+    QVERIFY(m_database->noteValue(id, "length(note)").toInt() < note.size() / 10);
+    QCOMPARE(m_database->noteValue(id, "note").toString(), note);
+    QCOMPARE(m_database->note(id).note, note);
+
+    m_database->updateNoteValue(id, "note", "Short");
+    QCOMPARE(m_database->noteValue(id, "compressed").toInt(), 0);
+    QCOMPARE(m_database->noteValue(id, "note").toString(), "Short");
+}
+
+void TestDatabase::compressionSize_data() {
+    QTest::addColumn<bool>("compress");
+
+    QTest::newRow("plain") << false;
+    QTest::newRow("compressed") << true;
+}
+
+void TestDatabase::compressionSize() {
+    QFETCH(bool, compress);
+
+    m_database->setCompressNotes(compress);
+    QString note = largeNote();
+
+    for (int i = 0; i < 10; i++) {
+        Id id = m_database->insertNote(0, i, 0, QString::number(i));
+        m_database->updateNoteValue(id, "note", note);
+    }
+
+    QBENCHMARK {
+        m_database->noteValue(1, "note");
+    }
+
+    qInfo().noquote() << "File size:" << QFileInfo(m_filePath).size() << "bytes";
+}
+
+void TestDatabase::queryPlan_data() {
+    QTest::addColumn<QString>("sql");
+    QTest::addColumn<QVariantMap>("params");
+    QTest::addColumn<QString>("index");
+
+    QTest::newRow("children") << "SELECT * FROM notes WHERE parent_id = :parent_id ORDER BY pos"
+                              << QVariantMap{ { "parent_id", 1 } } << "notes_parent_id_pos";
+    QTest::newRow("child count") << "SELECT COUNT(*) FROM notes WHERE parent_id = :parent_id"
+                                 << QVariantMap{ { "parent_id", 1 } } << "notes_parent_id_pos";
+    QTest::newRow("tree") << "SELECT * FROM notes ORDER BY depth, pos"
+                          << QVariantMap() << "notes_depth_pos";
+    QTest::newRow("updated") << "SELECT id FROM notes WHERE updated_at > :updated_at"
+                             << QVariantMap{ { "updated_at", "2026-01-01 00:00:00" } } << "notes_updated_at";
+    QTest::newRow("birthdays today") << "SELECT COUNT(*) FROM birthdays WHERE strftime('%m-%d', date) = :date"
+                                     << QVariantMap{ { "date", "10-19" } } << "birthdays_month_day";
+    QTest::newRow("birthdays") << "SELECT * FROM birthdays ORDER BY strftime('%m-%d', date) ASC"
+                               << QVariantMap() << "birthdays_month_day";
+}
+
+void TestDatabase::queryPlan() {
+    QFETCH(QString, sql);
+    QFETCH(QVariantMap, params);
+    QFETCH(QString, index);
+
+    QString plan = queryPlan(sql, params);
+
+    QVERIFY2(plan.contains(index), qPrintable(plan));
+    QVERIFY2(!plan.contains("TEMP B-TREE"), qPrintable(plan));
+
+    if (!params.isEmpty()) {
+        QVERIFY2(plan.contains("SEARCH"), qPrintable(plan));
+    }
+}
+
+void TestDatabase::updateDepth() {
+    Id rootId = m_database->insertNote(0, 0, 0, "Root");
+    Id otherId = m_database->insertNote(0, 1, 0, "Other");
+    Id targetId = m_database->insertNote(otherId, 0, 1, "Target");
+    Id subtreeId = m_database->insertNote(rootId, 0, 1, "Subtree");
+    Ids ids = { subtreeId };
+
+    m_database->transaction();
+
+    // Subtree of 5000 notes, 50 levels deep.
+    for (int i = 0; i < 4999; i++) {
+        Id parentId = ids.at(i / 100 * 100);
+        int depth = m_database->noteValue(parentId, "depth").toInt() + 1;
+        ids.append(m_database->insertNote(parentId, i, depth, QString("Note %1").arg(i)));
+    }
+
+    m_database->commit();
+
+    QVector<int> depths;
+
+    for (Id id : std::as_const(ids)) {
+        depths.append(m_database->noteValue(id, "depth").toInt());
+    }
+
+    m_database->updateNoteValue(subtreeId, "parent_id", targetId);
+
+    // Target is one level deeper than the old parent, so every depth changes.
+    QBENCHMARK_ONCE {
+        m_database->updateDepth(subtreeId, 2);
+    }
+
+    for (int i = 0; i < ids.size(); i++) {
+        QCOMPARE(m_database->noteValue(ids.at(i), "depth").toInt(), depths.at(i) + 1);
+    }
+
+    m_database->updateNoteValue(subtreeId, "parent_id", 0);
+    m_database->updateDepth(subtreeId, 0);
+
+    for (int i = 0; i < ids.size(); i++) {
+        QCOMPARE(m_database->noteValue(ids.at(i), "depth").toInt(), depths.at(i) - 1);
+    }
+
+    QCOMPARE(m_database->noteValue(rootId, "depth").toInt(), 0);
+    QCOMPARE(m_database->noteValue(otherId, "depth").toInt(), 0);
+    QCOMPARE(m_database->noteValue(targetId, "depth").toInt(), 1);
+}
+
+void TestDatabase::removeSubtrees() {
+    Id rootId = m_database->insertNote(0, 0, 0, "Root");
+    Id siblingId = m_database->insertNote(0, 1, 0, "Sibling");
+    Id otherId = m_database->insertNote(0, 2, 0, "Other");
+    Ids ids = { rootId };
+
+    m_database->transaction();
+
+    for (int i = 0; i < 4999; i++) {
+        Id parentId = ids.at(i / 10);
+        ids.append(m_database->insertNote(parentId, i, 0, QString("Note %1").arg(i)));
+    }
+
+    m_database->insertNote(siblingId, 0, 1, "Sibling child");
+    m_database->commit();
+
+    Ids removedIds;
+
+    QBENCHMARK_ONCE {
+        removedIds = m_database->removeSubtrees({ rootId, otherId });
+    }
+
+    ids.append(otherId);
+    std::sort(ids.begin(), ids.end());
+    std::sort(removedIds.begin(), removedIds.end());
+    QCOMPARE(removedIds, ids);
+    QCOMPARE(m_database->notes().count(), 2);
+    QCOMPARE(m_database->childCount(siblingId), 1);
+}
+
+void TestDatabase::editorState() {
+    Id id = m_database->insertNote(0, 0, 0, "Note");
+    m_database->updateNoteValue(id, "note", "Text");
+
+    EditorState state = m_database->editorState(id);
+    QCOMPARE(state.note, "Text");
+    QCOMPARE(state.line, 0);
+    QVERIFY(!state.markdown);
+
+    state.note = "Ignored";
+    state.line = 5;
+    state.markdown = true;
+    m_database->updateEditorState(id, state, false);
+
+    state = m_database->editorState(id);
+    QCOMPARE(state.note, "Text");
+    QCOMPARE(state.line, 5);
+    QVERIFY(state.markdown);
+    Id revision = state.revision;
+    QVERIFY(revision > 0);
+
+    state.note = largeNote();
+    m_database->updateEditorState(id, state, true);
+
+    QCOMPARE(m_database->noteValue(id, "compressed").toInt(), 1);
+    QCOMPARE(m_database->editorState(id).note, state.note);
+    QVERIFY(m_database->editorState(id).revision > revision);
+    QVERIFY(m_database->editorState(0).note.isNull());
+}
+
+void TestDatabase::switchNotes_data() {
+    QTest::addColumn<bool>("batch");
+
+    QTest::newRow("values") << false;
+    QTest::newRow("state") << true;
+}
+
+void TestDatabase::switchNotes() {
+    QFETCH(bool, batch);
+
+    Ids ids;
+    m_database->transaction();
+
+    for (int i = 0; i < 100; i++) {
+        Id id = m_database->insertNote(0, i, 0, QString("Note %1").arg(i));
+        m_database->updateNoteValue(id, "note", QString("Line of note %1\n").repeated(50).arg(i));
+        ids.append(id);
+    }
+
+    m_database->commit();
+
+    // Every switch saves the state of the previous note and loads the next one.
+    QBENCHMARK {
+        for (Id id : ids) {
+            if (batch) {
+                EditorState state = m_database->editorState(id);
+                m_database->updateEditorState(id, state, false);
+            } else {
+                m_database->noteValue(id, "markdown");
+                m_database->noteValue(id, "note");
+                int line = m_database->noteValue(id, "line").toInt();
+                m_database->updateNoteValue(id, "line", line);
+                m_database->updateNoteValue(id, "markdown", 0);
+            }
+        }
+    }
+}
+
+void TestDatabase::revisions() {
+    Id id = m_database->insertNote(0, 0, 0, "Note");
+    QString note = largeNote();
+    QStringList versions = { "First", note, note + "Appended", note.left(1000) + "Inserted" + note.mid(1001) + "Appended" };
+
+    for (const QString& version : versions) {
+        m_database->updateNoteValue(id, "note", version);
+    }
+
+    QVector<Revision> revisions = m_database->revisions(id);
+    QCOMPARE(revisions.count(), versions.count());
+
+    for (int i = 0; i < versions.count(); i++) {
+        const Revision& revision = revisions.at(versions.count() - i - 1);
+        QCOMPARE(revision.size, int(versions.at(i).size()));
+        QCOMPARE(m_database->revisionText(revision.id), versions.at(i));
+    }
+
+    // Small edits of a large note are stored as deltas.
+    QVERIFY(!revisions.at(0).keyframe);
+    QVERIFY(!revisions.at(1).keyframe);
+    QVERIFY(revisions.at(0).storedSize < 100);
+
+    m_database->updateNoteValue(id, "note", versions.last());
+    QCOMPARE(m_database->revisions(id).count(), versions.count());
+
+    m_database->removeSubtrees({ id });
+    QVERIFY(m_database->revisions(id).isEmpty());
+}
+
+void TestDatabase::revisionKeyframes() {
+    Id id = m_database->insertNote(0, 0, 0, "Note");
+    QString initial = QString("Text ").repeated(100);
+    QString note = initial;
+    m_database->updateNoteValue(id, "note", note);
+
+    // Note changed without a revision, history restarts from the stored text.
+    m_database->exec("DELETE FROM revisions");
+
+    for (int i = 0; i < 40; i++) {
+        note += QString(" %1").arg(i);
+        m_database->updateNoteValue(id, "note", note);
+    }
+
+    QVector<Revision> revisions = m_database->revisions(id);
+    QCOMPARE(revisions.count(), 41);
+    QVERIFY(revisions.last().keyframe);
+    QCOMPARE(m_database->revisionText(revisions.last().id), initial);
+    QCOMPARE(m_database->revisionText(revisions.first().id), note);
+
+    int keyframes = std::count_if(revisions.cbegin(), revisions.cend(), [] (const Revision& revision) { return revision.keyframe; });
+    QCOMPARE(keyframes, 3);
+}
+
+void TestDatabase::pruneRevisions() {
+    Id id = m_database->insertNote(0, 0, 0, "Note");
+    Id otherId = m_database->insertNote(0, 1, 0, "Other");
+    QStringList versions;
+
+    for (int i = 0; i < 20; i++) {
+        versions.append(QString("Version %1 ").arg(i) + QString("text ").repeated(20));
+        m_database->updateNoteValue(id, "note", versions.last());
+    }
+
+    m_database->updateNoteValue(otherId, "note", "Other");
+    m_database->exec("UPDATE revisions SET created_at = datetime('now', 'localtime', '-10 days') WHERE note_id = :id", { { "id", otherId } });
+
+    QCOMPARE(m_database->pruneRevisions(0, 0), 0);
+    QCOMPARE(m_database->pruneRevisions(0, 5), 15);
+
+    QVector<Revision> revisions = m_database->revisions(id);
+    QCOMPARE(revisions.count(), 5);
+    QVERIFY(revisions.last().keyframe);
+
+    for (int i = 0; i < revisions.count(); i++) {
+        QCOMPARE(m_database->revisionText(revisions.at(i).id), versions.at(versions.count() - i - 1));
+    }
+
+    // Latest revision is kept even when it is older than the limit.
+    QCOMPARE(m_database->pruneRevisions(5, 0), 0);
+    QCOMPARE(m_database->revisions(otherId).count(), 1);
+
+    m_database->removeNote(otherId);
+    QVERIFY(m_database->revisions(otherId).isEmpty());
+}
+
+void TestDatabase::recoveryJournal() {
+    QString note = largeNote();
+    QString journalPath = RecoveryJournal::filePath(m_filePath);
+
+    {
+        RecoveryJournal journal;
+        journal.open(m_filePath);
+        journal.append(1, "First");
+        journal.append(1, note);
+        journal.append(2, "Saved");
+        journal.append(1, note + "Appended");
+        journal.markSaved(2);
+        journal.append(3, "Third");
+        journal.markSaved(3);
+        journal.append(3, "Third again");
+    }
+
+    // Edits are stored as deltas after the first text of a note.
+    QVERIFY(QFileInfo(journalPath).size() < qint64(note.toUtf8().size()) + 1024);
+
+    // Record torn by a crash is ignored.
+    QFile file(journalPath);
+    QVERIFY(file.open(QIODevice::Append));
+    file.write(QByteArray("\x00\x01\x00", 3));
+    file.close();
+
+    QVector<RecoveryJournal::Entry> entries = RecoveryJournal::read(m_filePath);
+    QCOMPARE(entries.count(), 2);
+    QCOMPARE(entries.at(0).id, Id(1));
+    QCOMPARE(entries.at(0).note, note + "Appended");
+    QCOMPARE(entries.at(1).id, Id(3));
+    QCOMPARE(entries.at(1).note, "Third again");
+
+    int size = int(note.size());
+
+    {
+        RecoveryJournal journal;
+        journal.open(m_filePath);
+        QVERIFY(RecoveryJournal::read(m_filePath).isEmpty());
+
+        // Large notes journal only the edited range against their stored text.
+        journal.appendChange(1, size, 10, size - 20, "Inserted");
+        journal.appendChange(1, size, 10, size - 20, "Inserted again");
+        journal.appendChange(2, size, 0, size, "Saved");
+        journal.markSaved(2);
+    }
+
+    QVERIFY(QFileInfo(journalPath).size() < 1024);
+
+    entries = RecoveryJournal::read(m_filePath);
+    QCOMPARE(entries.count(), 1);
+    QCOMPARE(entries.at(0).id, Id(1));
+    QCOMPARE(entries.at(0).baseSize, size);
+    QCOMPARE(Database::applyDelta(note, entries.at(0).change), note.left(10) + "Inserted again" + note.right(size - 20));
+
+    {
+        RecoveryJournal journal;
+        journal.open(m_filePath);
+        QVERIFY(RecoveryJournal::read(m_filePath).isEmpty());
+
+        journal.append(1, "Text");
+        journal.markSaved(1);
+        journal.appendChange(2, 4, 0, 4, "Text");
+        journal.markSaved(2);
+    }
+
+    QVERIFY(!QFile::exists(journalPath));
+}
+
+void TestDatabase::search() {
+    Id rootId = m_database->insertNote(0, 0, 0, "Root");
+    Id childId = m_database->insertNote(rootId, 0, 1, "Child");
+    Id logId = m_database->insertNote(rootId, 1, 1, "Log");
+    m_database->insertNote(0, 1, 0, "Other");
+
+    m_database->updateNoteValue(childId, "note", "Find the NEEDLE here");
+    m_database->updateNoteValue(logId, "note", largeNote() + "needle");
+
+    Search::Options options;
+    options.text = "Needle";
+    QVector<FindNote> notes = search(options);
+
+    QCOMPARE(notes.count(), 2);
+    QCOMPARE(notes.at(0).title, "Root > Child");
+    QCOMPARE(notes.at(0).snippet, "Find the NEEDLE here");
+    QCOMPARE(notes.at(0).matches.count(), 1);
+    QCOMPARE(notes.at(0).matches.at(0).offset, 9);
+    QCOMPARE(notes.at(0).matchText, "NEEDLE");
+    QCOMPARE(notes.at(1).title, "Root > Log");
+    QVERIFY(notes.at(1).snippet.startsWith("..."));
+    QVERIFY(notes.at(0).score > notes.at(1).score);
+}
+
+void TestDatabase::searchOptions_data() {
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<bool>("regex");
+    QTest::addColumn<bool>("wholeWords");
+    QTest::addColumn<bool>("caseSensitive");
+    QTest::addColumn<int>("field");
+    QTest::addColumn<bool>("subtree");
+    QTest::addColumn<Ids>("ids");
+
+    QTest::newRow("substring") << "cat" << false << false << false << int(Search::Field::All) << false << Ids({ 1, 2, 3, 4 });
+    QTest::newRow("whole words") << "cat" << false << true << false << int(Search::Field::All) << false << Ids({ 2, 3, 4 });
+    QTest::newRow("case sensitive") << "Cat" << false << false << true << int(Search::Field::All) << false << Ids({ 1, 3 });
+    QTest::newRow("title") << "cat" << false << false << false << int(Search::Field::Title) << false << Ids({ 1, 3 });
+    QTest::newRow("note") << "cat" << false << false << false << int(Search::Field::Note) << false << Ids({ 2, 4 });
+    QTest::newRow("regex") << "c[a-z]t\\b" << true << false << false << int(Search::Field::All) << false << Ids({ 2, 3, 4 });
+    QTest::newRow("subtree") << "cat" << false << false << false << int(Search::Field::All) << true << Ids({ 1, 2 });
+    QTest::newRow("unicode") << "ÉCOLE" << false << false << false << int(Search::Field::All) << false << Ids({ 4 });
+    QTest::newRow("like wildcard") << "100%" << false << false << false << int(Search::Field::All) << false << Ids({ 3 });
+}
+
+void TestDatabase::searchOptions() {
+    QFETCH(QString, text);
+    QFETCH(bool, regex);
+    QFETCH(bool, wholeWords);
+    QFETCH(bool, caseSensitive);
+    QFETCH(int, field);
+    QFETCH(bool, subtree);
+    QFETCH(Ids, ids);
+
+    Id rootId = m_database->insertNote(0, 0, 0, "Catalog");
+    Id childId = m_database->insertNote(rootId, 0, 1, "Child");
+    Id catId = m_database->insertNote(0, 1, 0, "Cat");
+    Id dogId = m_database->insertNote(0, 2, 0, "Dog");
+
+    m_database->updateNoteValue(childId, "note", "a black cat");
+    m_database->updateNoteValue(catId, "note", "100% fluffy");
+    m_database->updateNoteValue(dogId, "note", "chased the cat to école\n" + largeNote());
+
+    Search::Options options;
+    options.text = text;
+    options.regex = regex;
+    options.wholeWords = wholeWords;
+    options.caseSensitive = caseSensitive;
+    options.field = Search::Field(field);
+    options.rootId = subtree ? rootId : 0;
+
+    Ids result;
+
+    for (const FindNote& note : search(options)) {
+        result.append(note.id);
+    }
+
+    std::sort(result.begin(), result.end());
+    QCOMPARE(result, ids);
+}
+
+void TestDatabase::replace() {
+    Id firstId = m_database->insertNote(0, 0, 0, "Old name");
+    Id secondId = m_database->insertNote(0, 1, 0, "Other");
+    m_database->updateNoteValue(firstId, "note", "old text, OLD text");
+    m_database->updateNoteValue(secondId, "note", "c:\\old\\path");
+    m_database->updateNoteValue(firstId, "updated_at", "2000-01-01 00:00:00");
+
+    Search::Options options;
+    options.text = "old";
+    QVector<Note> notes;
+
+    int count = Search::replace({ firstId, secondId }, options, "new\\1", m_database.data(), notes);
+
+    QCOMPARE(count, 4);
+    QCOMPARE(notes.count(), 2);
+    QCOMPARE(m_database->noteValue(firstId, "title").toString(), "new\\1 name");
+    QCOMPARE(m_database->noteValue(firstId, "note").toString(), "new\\1 text, new\\1 text");
+    QCOMPARE(m_database->noteValue(secondId, "note").toString(), "c:\\new\\1\\path");
+    QVERIFY(m_database->noteValue(firstId, "updated_at").toString() > "2000-01-01 00:00:00");
+
+    m_database->updateNoteValue(firstId, "note", "alpha text, beta text");
+
+    options.text = "(\\w+) text";
+    options.regex = true;
+    options.field = Search::Field::Note;
+
+    count = Search::replace({ firstId }, options, "text \\1", m_database.data(), notes);
+
+    QCOMPARE(count, 2);
+    QCOMPARE(m_database->noteValue(firstId, "note").toString(), "text alpha, text beta");
+    QCOMPARE(m_database->noteValue(firstId, "title").toString(), "new\\1 name");
+}
+
+void TestDatabase::replaceMany() {
+    Ids ids;
+
+    m_database->transaction();
+
+    for (int i = 0; i < 2000; i++) {
+        Id id = m_database->insertNote(0, i, 0, QString("Note %1").arg(i));
+        m_database->updateNoteValue(id, "note", QString("Version 1 of note %1\n").repeated(20).arg(i));
+        ids.append(id);
+    }
+
+    m_database->commit();
+
+    Search::Options options;
+    options.text = "Version 1";
+    QVector<Note> notes;
+    int count = 0;
+
+    QBENCHMARK_ONCE {
+        count = Search::replace(ids, options, "Version 2", m_database.data(), notes);
+    }
+
+    QCOMPARE(count, 2000 * 20);
+}
+
+QVector<FindNote> TestDatabase::search(const Search::Options& options) {
+    Search search;
+    QSignalSpy finishedSpy(&search, &Search::finished);
+    QVector<FindNote> result;
+
+    connect(&search, &Search::found, this, [&] (const QVector<FindNote>& notes) {
+        result += notes;
+    });
+
+    search.start(m_filePath, options);
+    finishedSpy.wait();
+
+    return result;
+}
+
+QString TestDatabase::largeNote() const {
+    QString result;
+    result.reserve(NoteSize);
+
+    for (int i = 0; result.size() < NoteSize; i++) {
+        result += QString("2026-10-19 12:00:%1 [Info] Request %2 finished\n").arg(i % 60, 2, 10, QChar('0')).arg(i);
+    }
+
+    return result;
+}
+
+QString TestDatabase::queryPlan(const QString& sql, const QVariantMap& params) const {
+    QSqlQuery query = m_database->exec("EXPLAIN QUERY PLAN " + sql, params);
+    QStringList result;
+
+    while (query.next()) {
+        result.append(query.value("detail").toString());
+    }
+
+    return result.join("\n");
+}
+
+QTEST_MAIN(TestDatabase)
+
+#include "tst_database.moc"
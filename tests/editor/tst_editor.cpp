@@ -0,0 +1,178 @@
+#include <ui/Editor.h>
+#include <ui/DocumentCache.h>
+#include <QTest>
+#include <QSignalSpy>
+
+constexpr auto LineCount = 100000;
+
+class TestEditor : public QObject {
+    Q_OBJECT
+private slots:
+    void loadLargeNote();
+    void saveLargeNote();
+    void smallNote();
+    void documentCache();
+    void markdownRendering();
+
+private:
+    QString largeNote() const;
+    QString markdownNote() const;
+};
+
+void TestEditor::loadLargeNote() {
+    Editor editor;
+    QSignalSpy loadedSpy(&editor, &Editor::loaded);
+    QString note = largeNote();
+
+    editor.setNote(note);
+    editor.setLine(500);
+
+    QVERIFY(editor.isLarge());
+    QVERIFY(editor.isLoading());
+    QCOMPARE(editor.note(), note);
+    QCOMPARE(editor.line(), 500);
+
+    QVERIFY(loadedSpy.wait());
+    QVERIFY(!editor.isLoading());
+    QVERIFY(!editor.document()->isModified());
+    QCOMPARE(editor.toPlainText(), note);
+    QCOMPARE(editor.line(), 500);
+}
+
+void TestEditor::saveLargeNote() {
+    Editor editor;
+    QSignalSpy loadedSpy(&editor, &Editor::loaded);
+    editor.setNote(largeNote());
+    QVERIFY(loadedSpy.wait());
+
+    QTextCursor cursor(editor.document());
+    cursor.setPosition(1000);
+    cursor.insertText("inserted\nlines\n");
+    QCOMPARE(editor.note(), editor.toPlainText());
+
+    cursor.setPosition(500000);
+    cursor.setPosition(500100, QTextCursor::KeepAnchor);
+    cursor.removeSelectedText();
+    QCOMPARE(editor.note(), editor.toPlainText());
+
+    cursor.movePosition(QTextCursor::End);
+    cursor.insertText("tail");
+    QCOMPARE(editor.note(), editor.toPlainText());
+
+    cursor.movePosition(QTextCursor::Start);
+    cursor.deleteChar();
+    QCOMPARE(editor.note(), editor.toPlainText());
+
+    QBENCHMARK {
+        editor.note();
+    }
+}
+
+void TestEditor::smallNote() {
+    Editor editor;
+    editor.setNote("Small note");
+
+    QVERIFY(!editor.isLarge());
+    QCOMPARE(editor.note(), "Small note");
+}
+
+void TestEditor::documentCache() {
+    Editor editor;
+    DocumentCache cache;
+    cache.setLimit(1024 * 1024);
+
+    editor.setNote("First note");
+    QTextCursor cursor(editor.document());
+    cursor.movePosition(QTextCursor::End);
+    cursor.insertText(" edited");
+    editor.setTextCursor(cursor);
+
+    cache.insert(1, editor.takeDocument());
+    QCOMPARE(cache.count(), 1);
+    QVERIFY(editor.toPlainText().isEmpty());
+
+    editor.setNote("Second note");
+
+    Editor::Snapshot snapshot;
+    QVERIFY(!cache.take(2, snapshot));
+    QVERIFY(cache.take(1, snapshot));
+    QCOMPARE(cache.count(), 0);
+    QCOMPARE(cache.size(), 0);
+
+    editor.restoreDocument(snapshot);
+    QCOMPARE(editor.note(), "First note edited");
+    QCOMPARE(editor.textCursor().position(), 17);
+
+    editor.undo();
+    QCOMPARE(editor.note(), "First note");
+
+    // Least recently used documents are evicted first.
+    QString note(100 * 1024, 'a');
+    qint64 cost = 0;
+
+    for (Id id = 1; id <= 20; id++) {
+        editor.setNote(note);
+        cost = DocumentCache::cost(editor.document());
+        cache.insert(id, editor.takeDocument());
+    }
+
+    QVERIFY(cache.size() <= cache.limit());
+    QCOMPARE(cache.count(), int(cache.limit() / cost));
+    QVERIFY(!cache.take(1, snapshot));
+    QVERIFY(cache.take(20, snapshot));
+    delete snapshot.document;
+
+    cache.setLimit(0);
+    QCOMPARE(cache.count(), 0);
+    QCOMPARE(cache.size(), 0);
+}
+
+void TestEditor::markdownRendering() {
+    Editor editor;
+    editor.setId(1);
+    QSignalSpy replacedSpy(&editor, &Editor::documentReplaced);
+    QString markdown = markdownNote();
+
+    editor.setNote(markdown, Editor::Mode::Markdown);
+    QVERIFY(editor.isRendering());
+    QCOMPARE(editor.note(), markdown);
+
+    QVERIFY(replacedSpy.wait());
+    QVERIFY(!editor.isRendering());
+    QVERIFY(!editor.toPlainText().contains("## "));
+    QCOMPARE(editor.note(), markdown);
+
+    editor.setMode(Editor::Mode::Plain);
+    QCOMPARE(editor.toPlainText(), markdown);
+
+    // Rendered document is reused when the same text is viewed again.
+    replacedSpy.clear();
+    editor.setMode(Editor::Mode::Markdown);
+    QVERIFY(!editor.isRendering());
+    QCOMPARE(replacedSpy.count(), 1);
+    QVERIFY(!editor.toPlainText().contains("## "));
+}
+
+QString TestEditor::largeNote() const {
+    QString result;
+
+    for (int i = 0; i < LineCount; i++) {
+        result += QString("Line %1 of a large note\n").arg(i);
+    }
+
+    return result;
+}
+
+QString TestEditor::markdownNote() const {
+    QString result;
+
+    for (int i = 0; result.size() < 256 * 1024; i++) {
+        result += QString("## Section %1\n\nParagraph with **bold** text in section %1.\n\n").arg(i);
+    }
+
+    return result;
+}
+
+QTEST_MAIN(TestEditor)
+
+#include "tst_editor.moc"
@@ -0,0 +1,98 @@
+#include <ui/notetaking/TitleIndex.h>
+#include <QTest>
+
+constexpr auto IndexSize = 100000;
+constexpr auto FolderSize = 100;
+
+class TestTitleIndex : public QObject {
+    Q_OBJECT
+private slots:
+    void match();
+    void update();
+    void visibleSlots();
+    void filterLargeIndex();
+
+private:
+    Ids ids(const TitleIndex& index, const QVector<int>& visibleSlots);
+};
+
+void TestTitleIndex::match() {
+    TitleIndex index;
+    index.insert(1, 0, "Recipes");
+    index.insert(2, 1, "Pancakes");
+    index.insert(3, 1, "Cheesecake");
+    index.insert(4, 0, "Work");
+
+    QCOMPARE(ids(index, index.match("cake")), Ids({ 2, 3 }));
+    QCOMPARE(ids(index, index.match("cakes")), Ids({ 2 }));
+    QCOMPARE(ids(index, index.match("CHEESE")), Ids({ 3 }));
+    QCOMPARE(ids(index, index.match("e")), Ids({ 1, 2, 3 }));
+    QCOMPARE(ids(index, index.match("xyz")), Ids());
+    QCOMPARE(ids(index, index.match("")), Ids());
+}
+
+void TestTitleIndex::update() {
+    TitleIndex index;
+    index.insert(1, 0, "Alpha");
+    index.insert(2, 0, "Beta");
+
+    QCOMPARE(ids(index, index.match("alp")), Ids({ 1 }));
+
+    index.rename(1, "Gamma");
+    QCOMPARE(ids(index, index.match("alp")), Ids());
+    QCOMPARE(ids(index, index.match("gam")), Ids({ 1 }));
+
+    index.rename(1, "Alpha Gamma");
+    QCOMPARE(ids(index, index.match("alp")), Ids({ 1 }));
+
+    index.remove(2);
+    QCOMPARE(ids(index, index.match("bet")), Ids());
+    QCOMPARE(index.count(), 1);
+}
+
+void TestTitleIndex::visibleSlots() {
+    TitleIndex index;
+    index.insert(1, 0, "Root");
+    index.insert(2, 1, "Folder");
+    index.insert(3, 2, "Target");
+    index.insert(4, 1, "Other");
+
+    QCOMPARE(ids(index, index.visibleSlots(index.match("target"))), Ids({ 1, 2, 3 }));
+
+    index.move(3, 4);
+    QCOMPARE(ids(index, index.visibleSlots(index.match("target"))), Ids({ 1, 3, 4 }));
+}
+
+void TestTitleIndex::filterLargeIndex() {
+    TitleIndex index;
+
+    for (int i = 0; i < IndexSize; i++) {
+        Id parentId = i < FolderSize ? 0 : i / FolderSize;
+        index.insert(i + 1, parentId, QString("Note %1 title").arg(i));
+    }
+
+    QStringList keystrokes = { "n", "no", "not", "note", "note ", "note 4", "note 42", "note 421" };
+    int count = 0;
+
+    QBENCHMARK {
+        for (const QString& text : keystrokes) {
+            count = index.visibleSlots(index.match(text)).count();
+        }
+    }
+
+    QVERIFY(count > 0);
+}
+
+Ids TestTitleIndex::ids(const TitleIndex& index, const QVector<int>& visibleSlots) {
+    Ids result;
+
+    for (int slot : visibleSlots) {
+        result.append(index.entry(slot).id);
+    }
+
+    return result;
+}
+
+QTEST_MAIN(TestTitleIndex)
+
+#include "tst_titleindex.moc"
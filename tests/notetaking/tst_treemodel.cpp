@@ -0,0 +1,242 @@
+#include <ui/notetaking/TreeModel.h>
+#include <ui/notetaking/TreeItem.h>
+#include <database/Database.h>
+#include <QTest>
+#include <QSignalSpy>
+#include <QMimeData>
+
+constexpr auto ChildCount = 20000;
+constexpr auto TreeSize = 100000;
+constexpr auto FolderSize = 100;
+
+class TestTreeModel : public QObject {
+    Q_OBJECT
+private slots:
+    void childNumber();
+    void moveRows();
+    void positionBetween();
+    void dropItems();
+    void removeItems();
+    void scrollLargeFolder();
+    void buildLargeTree();
+    void traverseLargeTree();
+
+private:
+    QModelIndex appendItem(TreeModel& model, const QModelIndex& parent, Id id);
+    void fillTree(TreeModel& model);
+};
+
+void TestTreeModel::childNumber() {
+    TreeModel model;
+
+    for (int i = 0; i < 5; i++) {
+        appendItem(model, QModelIndex(), i + 1);
+    }
+
+    TreeItem* root = model.root();
+    model.insertRow(2);
+    model.removeRow(0);
+
+    for (int i = 0; i < root->childCount(); i++) {
+        QCOMPARE(root->child(i)->childNumber(), i);
+    }
+
+    QCOMPARE(root->child(0)->id(), Id(2));
+    QCOMPARE(root->child(1)->id(), Id(0));
+    QCOMPARE(root->child(2)->id(), Id(3));
+}
+
+void TestTreeModel::moveRows() {
+    TreeModel model;
+
+    for (int i = 0; i < 4; i++) {
+        appendItem(model, QModelIndex(), i + 1);
+    }
+
+    TreeItem* root = model.root();
+
+    QVERIFY(model.moveRow(QModelIndex(), 0, QModelIndex(), 3));
+    QCOMPARE(root->child(2)->id(), Id(1));
+    QCOMPARE(root->child(2)->childNumber(), 2);
+
+    QVERIFY(model.moveRow(QModelIndex(), 3, QModelIndex(), 0));
+    QCOMPARE(root->child(0)->id(), Id(4));
+    QCOMPARE(root->child(0)->childNumber(), 0);
+    QCOMPARE(root->child(3)->childNumber(), 3);
+    QCOMPARE(root->childCount(), 4);
+}
+
+void TestTreeModel::positionBetween() {
+    constexpr auto Gap = Database::PositionGap;
+    TreeItem previous;
+    TreeItem next;
+
+    QCOMPARE(TreeModel::positionBetween(nullptr, nullptr).value_or(-1), Gap);
+
+    previous.setPos(Gap);
+    next.setPos(2 * Gap);
+    QCOMPARE(TreeModel::positionBetween(&previous, nullptr).value_or(-1), 2 * Gap);
+    QCOMPARE(TreeModel::positionBetween(nullptr, &previous).value_or(-1), 0);
+    QCOMPARE(TreeModel::positionBetween(&previous, &next).value_or(-1), Gap + Gap / 2);
+
+    // Repeated inserts before the same note halve the gap until it is used up.
+    int count = 0;
+
+    while (std::optional<int> pos = TreeModel::positionBetween(&previous, &next)) {
+        next.setPos(*pos);
+        count++;
+    }
+
+    QCOMPARE(count, 10);
+    QCOMPARE(next.pos(), Gap + 1);
+
+    previous.setPos(std::numeric_limits<int>::max() - 1);
+    QVERIFY(!TreeModel::positionBetween(&previous, nullptr));
+}
+
+void TestTreeModel::dropItems() {
+    TreeModel model;
+
+    for (int i = 0; i < 5; i++) {
+        appendItem(model, QModelIndex(), i + 1);
+    }
+
+    QModelIndex folder = model.index(4, 0, QModelIndex());
+    appendItem(model, folder, 6);
+    appendItem(model, model.index(0, 0, QModelIndex()), 7);
+
+    // Selected child of a selected note is not dragged separately.
+    QModelIndexList indexes = {
+        model.index(2, 0, QModelIndex()),
+        model.index(0, 0, model.index(0, 0, QModelIndex())),
+        model.index(0, 0, QModelIndex()),
+    };
+
+    // Indexes inside the dropped subtrees stay valid, so the view keeps them expanded.
+    QPersistentModelIndex childIndex = indexes.at(1);
+
+    QSignalSpy droppedSpy(&model, &TreeModel::itemsDropped);
+    QScopedPointer<QMimeData> mimeData(model.mimeData(indexes));
+    model.dropMimeData(mimeData.data(), Qt::MoveAction, 1, 0, folder);
+
+    TreeItem* root = model.root();
+    TreeItem* folderItem = model.item(model.index(2, 0, QModelIndex()));
+
+    QCOMPARE(droppedSpy.count(), 1);
+    QCOMPARE(droppedSpy.at(0).at(1).toInt(), 1);
+    QCOMPARE(droppedSpy.at(0).at(2).toInt(), 2);
+    QCOMPARE(droppedSpy.at(0).at(3).value<Ids>(), Ids({ 0, 0 }));
+
+    QCOMPARE(root->childCount(), 3);
+    QCOMPARE(folderItem->id(), Id(5));
+    QCOMPARE(folderItem->childCount(), 3);
+    QCOMPARE(folderItem->child(0)->id(), Id(6));
+    QCOMPARE(folderItem->child(1)->id(), Id(1));
+    QCOMPARE(folderItem->child(2)->id(), Id(3));
+    QCOMPARE(folderItem->child(1)->child(0)->id(), Id(7));
+
+    QVERIFY(childIndex.isValid());
+    QCOMPARE(model.item(childIndex)->id(), Id(7));
+    QCOMPARE(childIndex.parent().row(), 1);
+
+    // Note can't be dropped into itself.
+    mimeData.reset(model.mimeData({ model.index(2, 0, QModelIndex()) }));
+    QVERIFY(!model.dropMimeData(mimeData.data(), Qt::MoveAction, -1, 0, model.index(1, 0, model.index(2, 0, QModelIndex()))));
+    QCOMPARE(root->childCount(), 3);
+}
+
+void TestTreeModel::removeItems() {
+    TreeModel model;
+
+    for (int i = 0; i < 6; i++) {
+        appendItem(model, QModelIndex(), i + 1);
+    }
+
+    TreeItem* root = model.root();
+    model.removeItems({ root->child(1), root->child(2), root->child(4) });
+
+    QCOMPARE(root->childCount(), 3);
+    QCOMPARE(root->child(0)->id(), Id(1));
+    QCOMPARE(root->child(1)->id(), Id(4));
+    QCOMPARE(root->child(2)->id(), Id(6));
+    QCOMPARE(root->child(2)->childNumber(), 2);
+}
+
+void TestTreeModel::scrollLargeFolder() {
+    TreeModel model;
+    QModelIndex folder = appendItem(model, QModelIndex(), 1);
+
+    for (int i = 0; i < ChildCount; i++) {
+        QModelIndex index = appendItem(model, folder, i + 2);
+        appendItem(model, index, ChildCount + i + 2);
+    }
+
+    TreeItem* folderItem = model.item(folder);
+    int rows = 0;
+
+    // Scrolling asks parent() of every visible row.
+    QBENCHMARK {
+        rows = 0;
+
+        for (int i = 0; i < ChildCount; i++) {
+            QModelIndex index = model.index(folderItem->child(i));
+            QModelIndex child = model.index(0, 0, index);
+            rows += model.parent(child).row() == i;
+        }
+    }
+
+    QCOMPARE(rows, ChildCount);
+}
+
+void TestTreeModel::buildLargeTree() {
+    qInfo().noquote() << "Item size:" << sizeof(TreeItem) << "bytes";
+
+    QBENCHMARK {
+        TreeModel model;
+        fillTree(model);
+    }
+}
+
+void TestTreeModel::traverseLargeTree() {
+    TreeModel model;
+    fillTree(model);
+
+    TreeItem* item = nullptr;
+    int count = 0;
+
+    QBENCHMARK {
+        item = model.root()->find(TreeSize);
+        count = model.childIds(model.root()).count();
+    }
+
+    QVERIFY(item);
+    QCOMPARE(item->depth(), 2);
+    QCOMPARE(count, TreeSize + 1);
+}
+
+QModelIndex TestTreeModel::appendItem(TreeModel& model, const QModelIndex& parent, Id id) {
+    int row = model.rowCount(parent);
+    model.insertRow(row, parent);
+
+    QModelIndex result = model.index(row, 0, parent);
+    model.setData(result, QString::number(id));
+    model.item(result)->setId(id);
+
+    return result;
+}
+
+void TestTreeModel::fillTree(TreeModel& model) {
+    QModelIndex folder;
+
+    for (int i = 0; i < TreeSize; i++) {
+        if (i % FolderSize == 0) {
+            folder = appendItem(model, QModelIndex(), i + 1);
+        } else {
+            appendItem(model, folder, i + 1);
+        }
+    }
+}
+
+QTEST_MAIN(TestTreeModel)
+
+#include "tst_treemodel.moc"